@@ -7,6 +7,8 @@
 #include <cmath>
 #include <cstdint>
 #include <functional>
+#include <limits>
+#include <optional>
 #include <utility>
 
 namespace eng::alg {
@@ -114,6 +116,28 @@ std::array<Coord, dimensions * 2> boundingBox(Iter begin, Iter end)
     return result;
 }
 
+/*
+ * Box is in format of boundingBox<3>, point p is inside of plane if
+ * plane * (p, 1) >= 0. Box is outside if all its corners are outside of one
+ * of planes, box which is outside of region only near its corner may be not
+ * detected, so result is conservative.
+ */
+template <std::size_t planesCount>
+[[nodiscard]] bool
+isBoxOutside(const std::array<floating, 6> &box,
+             const std::array<vec::Vec4F, planesCount> &planes) noexcept
+{
+    for (const auto &plane : planes) {
+        // corner which is the farthest along plane normal
+        vec::Vec4F corner{plane[0] < 0 ? box[0] : box[1],
+                          plane[1] < 0 ? box[2] : box[3],
+                          plane[2] < 0 ? box[4] : box[5], 1};
+        if (plane * corner < 0)
+            return true;
+    }
+    return false;
+}
+
 template <typename VertexIter, typename Out>
 void polygonTriangulation(VertexIter begin, VertexIter end, Out out)
 {
@@ -130,6 +154,150 @@ void drawTriangle(vec::Vec2I a, vec::Vec2I b, vec::Vec2I c, Out inserter)
     eng::alg::line(b[0], c[0], b[1], c[1], inserter);
 }
 
+// inclusive borders of screen region in pixels
+struct PixelRect {
+    uint32_t xMin, xMax, yMin, yMax;
+};
+
+// linear function of pixel position: value(x, y) = dx * x + dy * y + c
+struct LinearFunction {
+    floating dx, dy, c;
+
+    [[nodiscard]] constexpr floating operator()(floating x,
+                                                floating y) const noexcept
+    {
+        return dx * x + dy * y + c;
+    }
+};
+
+/*
+ * Edge functions are oriented to be positive inside of triangle, multiplied
+ * on inverseSquare2x they give barycentric coordinates: u belongs to a, v to
+ * b, w to c. Function of edge shared by two triangles is bitwise negation of
+ * the other one, because it's computed from the same vertices, so coverage is
+ * tested on them and not on divided values. Pixel exactly on edge is covered
+ * only if edge is top or left one (gradient points right or straight down),
+ * so pixels on shared edge are shaded exactly once.
+ */
+struct TriangleEdges {
+    std::array<LinearFunction, 3> edges;
+    std::array<bool, 3> inclusive;
+    floating inverseSquare2x;
+    LinearFunction z;
+
+    [[nodiscard]] constexpr bool covers(unsigned edge,
+                                        floating value) const noexcept
+    {
+        return value > 0 || (value == 0 && inclusive[edge]);
+    }
+};
+
+// nullopt for degenerate triangle, it covers nothing
+[[nodiscard]] inline std::optional<TriangleEdges>
+setupTriangleEdges(vec::Vec3F a, vec::Vec3F b, vec::Vec3F c) noexcept
+{
+    auto triangleSquare2x = (c[0] - a[0]) * (b[1] - a[1]) -
+                            (c[1] - a[1]) * (b[0] - a[0]);
+    if (triangleSquare2x == 0 || !std::isfinite(triangleSquare2x))
+        return std::nullopt;
+    auto orientation = triangleSquare2x > 0 ? floating{1} : floating{-1};
+    auto edgeOpposite = [orientation](vec::Vec3F from, vec::Vec3F to) {
+        return LinearFunction{(from[1] - to[1]) * orientation,
+                              (to[0] - from[0]) * orientation,
+                              (from[0] * to[1] - from[1] * to[0]) *
+                                  orientation};
+    };
+    TriangleEdges result{
+        {edgeOpposite(c, b), edgeOpposite(a, c), edgeOpposite(b, a)},
+        {},
+        1 / std::abs(triangleSquare2x),
+        {}};
+    for (unsigned i = 0; i < 3; i++) {
+        auto [dx, dy, constant] = result.edges[i];
+        result.inclusive[i] = dx > 0 || (dx == 0 && dy > 0);
+    }
+    auto [u, v, w] = result.edges;
+    auto scale = result.inverseSquare2x;
+    auto dzdx = (a[2] * u.dx + b[2] * v.dx + c[2] * w.dx) * scale;
+    auto dzdy = (a[2] * u.dy + b[2] * v.dy + c[2] * w.dy) * scale;
+    // plane goes through a, constant terms of edge functions are too large
+    // for small triangles and would lose precision of depth
+    result.z = {dzdx, dzdy, a[2] - dzdx * a[0] - dzdy * a[1]};
+    return result;
+}
+
+// pixels of triangle bounding box inside of clip, nullopt if there are none
+[[nodiscard]] inline std::optional<PixelRect>
+triangleBounds(vec::Vec3F a, vec::Vec3F b, vec::Vec3F c,
+               PixelRect clip) noexcept
+{
+    using std::min, std::max;
+    // clamped before cast, so negative coordinates can't wrap
+    auto xMin = max(std::ceil(min({a[0], b[0], c[0]})),
+                    static_cast<floating>(clip.xMin));
+    auto yMin = max(std::ceil(min({a[1], b[1], c[1]})),
+                    static_cast<floating>(clip.yMin));
+    auto xMax = min(std::floor(max({a[0], b[0], c[0]})),
+                    static_cast<floating>(clip.xMax));
+    auto yMax = min(std::floor(max({a[1], b[1], c[1]})),
+                    static_cast<floating>(clip.yMax));
+    if (!(xMin <= xMax && yMin <= yMax))
+        return std::nullopt;
+    return PixelRect{static_cast<uint32_t>(xMin), static_cast<uint32_t>(xMax),
+                     static_cast<uint32_t>(yMin), static_cast<uint32_t>(yMax)};
+}
+
+constexpr uint32_t rasterizationBlockSize = 8;
+
+template <typename T>
+concept BlockVisitor = std::invocable<T, PixelRect, bool>;
+
+/*
+ * Walks bounds by blocks aligned to rasterizationBlockSize. Edge functions
+ * are linear, so their extremums over block are in its corners: block which
+ * is outside of any edge is skipped, block which is inside of all edges is
+ * reported as fully covered and needs no per pixel edge tests.
+ */
+void forEachTriangleBlock(const TriangleEdges &triangle, PixelRect bounds,
+                          BlockVisitor auto &&visitor)
+{
+    // blocks with pixels near edge are left to per pixel test, so rounding
+    // of corner values can't change coverage
+    constexpr auto tolerance = 32 * std::numeric_limits<floating>::epsilon();
+    constexpr auto alignMask = ~(rasterizationBlockSize - 1);
+    for (auto blockY = bounds.yMin & alignMask; blockY <= bounds.yMax;
+         blockY += rasterizationBlockSize) {
+        auto y0 = std::max(blockY, bounds.yMin);
+        auto y1 = std::min(blockY + rasterizationBlockSize - 1, bounds.yMax);
+        auto height = static_cast<floating>(y1 - y0);
+        for (auto blockX = bounds.xMin & alignMask; blockX <= bounds.xMax;
+             blockX += rasterizationBlockSize) {
+            auto x0 = std::max(blockX, bounds.xMin);
+            auto x1 =
+                std::min(blockX + rasterizationBlockSize - 1, bounds.xMax);
+            auto width = static_cast<floating>(x1 - x0);
+            bool outside = false, inside = true;
+            for (const auto &edge : triangle.edges) {
+                auto x = static_cast<floating>(x0),
+                     y = static_cast<floating>(y0);
+                auto corner = edge(x, y);
+                auto xStep = edge.dx * width, yStep = edge.dy * height;
+                auto maxValue = corner + std::max(xStep, floating{0}) +
+                                std::max(yStep, floating{0});
+                auto minValue = corner + std::min(xStep, floating{0}) +
+                                std::min(yStep, floating{0});
+                auto error = tolerance * (std::abs(edge.dx) * (x + width) +
+                                          std::abs(edge.dy) * (y + height) +
+                                          std::abs(edge.c));
+                outside = outside || maxValue < -error;
+                inside = inside && minValue > error;
+            }
+            if (!outside)
+                std::invoke(visitor, PixelRect{x0, x1, y0, y1}, inside);
+        }
+    }
+}
+
 template <typename T>
 concept ZBufferCheck = std::invocable<T, uint32_t, uint32_t, floating>;
 
@@ -137,44 +305,119 @@ template <typename T>
 concept BCOutput =
     std::invocable<T, uint32_t, uint32_t, floating, floating, floating>;
 
+/*
+ * Edge functions and z are evaluated in the first pixel of row of aligned
+ * block and stepped from it by lane number, so every triangle gets the same
+ * values in the same pixel no matter where its bounding box starts, and
+ * vector kernels which process whole row of block at once get them too.
+ */
+void rasterizeBlock(const TriangleEdges &triangle, PixelRect block,
+                    bool fullyCovered, ZBufferCheck auto &zCheck,
+                    BCOutput auto &out)
+{
+    auto [u, v, w] = triangle.edges;
+    auto scale = triangle.inverseSquare2x;
+    auto blockX = block.xMin & ~(rasterizationBlockSize - 1);
+    for (auto y = block.yMin; y <= block.yMax; y++) {
+        auto xStart = static_cast<floating>(blockX);
+        auto yRow = static_cast<floating>(y);
+        auto uRow = u(xStart, yRow), vRow = v(xStart, yRow),
+             wRow = w(xStart, yRow), zRow = triangle.z(xStart, yRow);
+        for (auto x = block.xMin; x <= block.xMax; x++) {
+            auto lane = static_cast<floating>(x - blockX);
+            auto uValue = uRow + lane * u.dx, vValue = vRow + lane * v.dx,
+                 wValue = wRow + lane * w.dx;
+            if ((fullyCovered ||
+                 (triangle.covers(0, uValue) && triangle.covers(1, vValue) &&
+                  triangle.covers(2, wValue))) &&
+                std::invoke(zCheck, x, y, zRow + lane * triangle.z.dx))
+                std::invoke(out, x, y, uValue * scale, vValue * scale,
+                            wValue * scale);
+        }
+    }
+}
+
+// only pixels inside of clip are visited, so triangle can be rasterized
+// partially, e.g. by tile which owns part of the screen
+void barycentricCoordinates(vec::Vec3F a, vec::Vec3F b, vec::Vec3F c,
+                            PixelRect clip, ZBufferCheck auto zCheck,
+                            BCOutput auto out)
+{
+    auto bounds = triangleBounds(a, b, c, clip);
+    auto edges = setupTriangleEdges(a, b, c);
+    if (!bounds || !edges)
+        return;
+    forEachTriangleBlock(*edges, *bounds,
+                         [&](PixelRect block, bool fullyCovered) {
+                             rasterizeBlock(*edges, block, fullyCovered,
+                                            zCheck, out);
+                         });
+}
+
 void barycentricCoordinates(vec::Vec3F a, vec::Vec3F b, vec::Vec3F c,
                             ZBufferCheck auto zCheck, BCOutput auto out)
 {
-    using namespace eng::vec;
-    using std::ceil, std::min, std::max;
-
-    auto a_b = (b - a).trim<2>();
-    auto a_c = (c - a).trim<2>();
-    auto b2 = b.trim<2>();
-    auto c2 = c.trim<2>();
-    auto a2 = a.trim<2>();
-    numeric auto triangleSquare2x = perpDot(a_c, a_b);
-    numeric auto denominator = 1 / triangleSquare2x;
-
-    // potentially bad assumption that there is no negative coordinates
-    // TODO make it accurate or clamp and then cast
-    auto xMin = static_cast<uint32_t>((ceil(min({a[0], b[0], c[0]}))));
-    auto yMin = static_cast<uint32_t>(ceil(min({a[1], b[1], c[1]})));
-    auto xMax = static_cast<uint32_t>(ceil(max({a[0], b[0], c[0]})));
-    auto yMax = static_cast<uint32_t>(ceil(max({a[1], b[1], c[1]})));
-    for (auto y = yMin; y <= yMax; y++) {
-        for (auto x = xMin; x <= xMax; x++) {
-            auto p = Vec2F{static_cast<floating>(x), static_cast<floating>(y)};
-            auto p_c = c2 - p;
-            auto p_b = b2 - p;
-            auto p_a = a2 - p;
-
-            numeric auto u = perpDot(p_c, p_b) * denominator;
-            numeric auto v = perpDot(p_a, p_c) * denominator;
-            numeric auto w = 1 - u - v;
-            if (v >= 0 && w >= 0 && u >= 0) {
-                // TODO potentially not accurate
-                auto z = a[2] * u + b[2] * v + c[2] * w;
-                if (std::invoke(zCheck, x, y, z))
-                    std::invoke(out, x, y, u, v, w);
-            }
+    constexpr auto maxCoordinate =
+        static_cast<uint32_t>(std::numeric_limits<int32_t>::max());
+    barycentricCoordinates(a, b, c,
+                           PixelRect{0, maxCoordinate, 0, maxCoordinate},
+                           zCheck, out);
+}
+
+// vertex of polygon clipped in homogeneous coordinates, weights are its
+// barycentric coordinates in source triangle
+struct ClipVertex {
+    vec::Vec4F position;
+    vec::Vec3F weights;
+};
+
+template <std::size_t capacity> struct ClippedPolygon {
+    std::array<ClipVertex, capacity> vertices;
+    std::size_t size;
+};
+
+/*
+ * Sutherland-Hodgman clipping of triangle by planes of homogeneous space,
+ * point p is inside of plane if plane * p >= 0. Every plane adds at most one
+ * vertex to polygon. New vertex is always interpolated from inside vertex of
+ * edge to outside one, so edge shared by two triangles is cut in the same
+ * point whatever direction they walk it.
+ */
+template <std::size_t planesCount>
+[[nodiscard]] ClippedPolygon<3 + planesCount>
+clipTriangle(const std::array<vec::Vec4F, 3> &triangle,
+             const std::array<vec::Vec4F, planesCount> &planes) noexcept
+{
+    ClippedPolygon<3 + planesCount> polygon{
+        {ClipVertex{triangle[0], {1, 0, 0}},
+         ClipVertex{triangle[1], {0, 1, 0}},
+         ClipVertex{triangle[2], {0, 0, 1}}},
+        3};
+    for (const auto &plane : planes) {
+        auto input = polygon;
+        polygon.size = 0;
+        for (std::size_t i = 0; i < input.size; i++) {
+            const auto &current = input.vertices[i];
+            const auto &next = input.vertices[(i + 1) % input.size];
+            auto currentDistance = plane * current.position;
+            auto nextDistance = plane * next.position;
+            if (currentDistance >= 0)
+                polygon.vertices[polygon.size++] = current;
+            if ((currentDistance >= 0) == (nextDistance >= 0))
+                continue;
+            const auto &inside = currentDistance >= 0 ? current : next;
+            const auto &outside = currentDistance >= 0 ? next : current;
+            auto insideDistance = std::max(currentDistance, nextDistance);
+            auto outsideDistance = std::min(currentDistance, nextDistance);
+            auto t = insideDistance / (insideDistance - outsideDistance);
+            polygon.vertices[polygon.size++] = {
+                inside.position + (outside.position - inside.position) * t,
+                inside.weights + (outside.weights - inside.weights) * t};
         }
+        if (polygon.size == 0)
+            break;
     }
+    return polygon;
 }
 
 } // namespace eng::alg
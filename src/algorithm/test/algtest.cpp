@@ -222,3 +222,224 @@ TEST_CASE("Polygon triangulation")
         CHECK(expected == triangles);
     }
 }
+
+TEST_CASE("Rasterization of triangle split by clip rectangles")
+{
+    eng::vec::Vec3F a{1.2f, 0.5f, 0.1f}, b{30.7f, 4.f, 0.5f},
+        c{9.f, 27.3f, 0.9f};
+    auto alwaysPass = [](uint32_t, uint32_t, eng::floating) { return true; };
+    std::vector<std::pair<uint32_t, uint32_t>> whole, tiled;
+    barycentricCoordinates(a, b, c, alwaysPass,
+                           [&whole](uint32_t x, uint32_t y, eng::floating,
+                                    eng::floating, eng::floating) {
+                               whole.emplace_back(x, y);
+                           });
+    for (uint32_t yTile = 0; yTile < 32; yTile += 8) {
+        for (uint32_t xTile = 0; xTile < 32; xTile += 8) {
+            barycentricCoordinates(
+                a, b, c, PixelRect{xTile, xTile + 7, yTile, yTile + 7},
+                alwaysPass,
+                [&tiled](uint32_t x, uint32_t y, eng::floating, eng::floating,
+                         eng::floating) { tiled.emplace_back(x, y); });
+        }
+    }
+    std::sort(whole.begin(), whole.end());
+    std::sort(tiled.begin(), tiled.end());
+    CHECK(!whole.empty());
+    CHECK(whole == tiled);
+}
+
+TEST_CASE("Rasterization of triangle with negative coordinates")
+{
+    std::vector<std::pair<uint32_t, uint32_t>> pixels;
+    barycentricCoordinates(
+        eng::vec::Vec3F{-10.f, -10.f, 0}, eng::vec::Vec3F{13.f, -10.f, 0},
+        eng::vec::Vec3F{-10.f, 13.f, 0}, PixelRect{0, 63, 0, 63},
+        [](uint32_t, uint32_t, eng::floating) { return true; },
+        [&pixels](uint32_t x, uint32_t y, eng::floating, eng::floating,
+                  eng::floating) { pixels.emplace_back(x, y); });
+    // pixels on hypotenuse belong to right bottom edge, so they are skipped
+    for (auto [x, y] : pixels)
+        CHECK(x + y < 3);
+    CHECK(pixels.size() == 6);
+}
+
+TEST_CASE("Pixels on shared edge are covered once")
+{
+    std::vector<int> coverage(32 * 32);
+    auto count = [&coverage](uint32_t x, uint32_t y, eng::floating,
+                             eng::floating, eng::floating) {
+        coverage[y * 32 + x]++;
+    };
+    auto alwaysPass = [](uint32_t, uint32_t, eng::floating) { return true; };
+    eng::vec::Vec3F a{0, 0, 0}, b{31, 0, 0}, c{31, 31, 0}, d{0, 31, 0};
+    // square from two triangles with different winding and diagonal through
+    // pixel centers, plus fan around its inner point
+    barycentricCoordinates(a, b, c, alwaysPass, count);
+    barycentricCoordinates(a, d, c, alwaysPass, count);
+    for (unsigned y = 0; y < 31; y++)
+        for (unsigned x = 0; x < 31; x++)
+            CHECK(coverage[y * 32 + x] == 1);
+
+    std::fill(coverage.begin(), coverage.end(), 0);
+    eng::vec::Vec3F center{13, 17, 0};
+    barycentricCoordinates(a, b, center, alwaysPass, count);
+    barycentricCoordinates(b, c, center, alwaysPass, count);
+    barycentricCoordinates(center, c, d, alwaysPass, count);
+    barycentricCoordinates(d, a, center, alwaysPass, count);
+    for (unsigned y = 0; y < 31; y++)
+        for (unsigned x = 0; x < 31; x++)
+            CHECK(coverage[y * 32 + x] == 1);
+
+    std::mt19937 mt(7);
+    std::uniform_int_distribution gridCoordinate(1, 29);
+    std::uniform_real_distribution coordinate(1.0f, 29.0f);
+    for (unsigned fan = 0; fan < 100; fan++) {
+        std::fill(coverage.begin(), coverage.end(), 0);
+        auto inner = fan % 2 ? eng::vec::Vec3F{coordinate(mt), coordinate(mt), 0}
+                             : eng::vec::Vec3F{
+                                   static_cast<eng::floating>(gridCoordinate(mt)),
+                                   static_cast<eng::floating>(gridCoordinate(mt)),
+                                   0};
+        std::array square{a, b, c, d};
+        for (unsigned i = 0; i < 4; i++)
+            barycentricCoordinates(square[i], square[(i + 1) % 4], inner,
+                                   alwaysPass, count);
+        auto coveredOnce = 0;
+        for (unsigned y = 0; y < 31; y++)
+            for (unsigned x = 0; x < 31; x++)
+                coveredOnce += coverage[y * 32 + x] == 1;
+        CHECK(coveredOnce == 31 * 31);
+    }
+}
+
+TEST_CASE("Block traversal matches per pixel edge test")
+{
+    std::mt19937 mt(42);
+    std::uniform_real_distribution coordinate(-20.0f, 120.0f);
+    for (unsigned i = 0; i < 200; i++) {
+        eng::vec::Vec3F a{coordinate(mt), coordinate(mt), 0.5f},
+            b{coordinate(mt), coordinate(mt), 0.5f},
+            c{coordinate(mt), coordinate(mt), 0.5f};
+        auto edges = setupTriangleEdges(a, b, c);
+        if (!edges)
+            continue;
+        // edge value of pixel is stepped from the first pixel of row of its
+        // block, as rasterizer defines it, so coverage is exact
+        auto value = [&edges](unsigned edge, uint32_t x, uint32_t y) {
+            const auto &function = edges->edges[edge];
+            auto xStart = x & ~(rasterizationBlockSize - 1);
+            return function(static_cast<eng::floating>(xStart),
+                            static_cast<eng::floating>(y)) +
+                   static_cast<eng::floating>(x - xStart) * function.dx;
+        };
+        std::vector<std::pair<uint32_t, uint32_t>> expected, actual;
+        for (uint32_t y = 0; y < 100; y++) {
+            for (uint32_t x = 0; x < 100; x++) {
+                if (edges->covers(0, value(0, x, y)) &&
+                    edges->covers(1, value(1, x, y)) &&
+                    edges->covers(2, value(2, x, y)))
+                    expected.emplace_back(x, y);
+            }
+        }
+        barycentricCoordinates(
+            a, b, c, PixelRect{0, 99, 0, 99},
+            [](uint32_t, uint32_t, eng::floating) { return true; },
+            [&actual](uint32_t x, uint32_t y, eng::floating u,
+                      eng::floating v, eng::floating w) {
+                CHECK(std::abs(u + v + w - 1) < 1e-3f);
+                actual.emplace_back(x, y);
+            });
+        std::sort(actual.begin(), actual.end());
+        std::sort(expected.begin(), expected.end());
+        CHECK(actual == expected);
+    }
+}
+
+TEST_CASE("Depth of small triangle far from origin stays in its range")
+{
+    eng::vec::Vec3F a{600.25f, 400.5f, 0.991f}, b{601.75f, 400.25f, 0.993f},
+        c{600.5f, 401.75f, 0.995f};
+    unsigned pixels = 0;
+    barycentricCoordinates(
+        a, b, c,
+        [&pixels](uint32_t, uint32_t, eng::floating z) {
+            pixels++;
+            CHECK(z >= 0.9909f);
+            CHECK(z <= 0.9951f);
+            return true;
+        },
+        [](uint32_t, uint32_t, eng::floating, eng::floating, eng::floating) {
+        });
+    CHECK(pixels == 1);
+}
+
+TEST_CASE("Clipping of triangle by planes")
+{
+    std::array<eng::vec::Vec4F, 3> triangle{eng::vec::Vec4F{0, 0, -1, 1},
+                                            eng::vec::Vec4F{4, 0, 1, 1},
+                                            eng::vec::Vec4F{0, 4, 1, 1}};
+    // z >= 0 and z <= w
+    std::array<eng::vec::Vec4F, 2> planes{eng::vec::Vec4F{0, 0, 1, 0},
+                                          eng::vec::Vec4F{0, 0, -1, 1}};
+    auto polygon = clipTriangle(triangle, planes);
+    REQUIRE(polygon.size == 4);
+    for (std::size_t i = 0; i < polygon.size; i++) {
+        const auto &[position, weights] = polygon.vertices[i];
+        CHECK(position[2] >= 0);
+        CHECK(position[2] <= position[3]);
+        CHECK(weights[0] + weights[1] + weights[2] == doctest::Approx(1));
+        auto restored = triangle[0] * weights[0] + triangle[1] * weights[1] +
+                        triangle[2] * weights[2];
+        for (unsigned j = 0; j < 4; j++)
+            CHECK(restored[j] == doctest::Approx(position[j]));
+    }
+
+    auto inside = clipTriangle(
+        std::array<eng::vec::Vec4F, 3>{eng::vec::Vec4F{0, 0, 0.5f, 1},
+                                       eng::vec::Vec4F{1, 0, 0.5f, 1},
+                                       eng::vec::Vec4F{0, 1, 0.5f, 1}},
+        planes);
+    CHECK(inside.size == 3);
+    auto outside = clipTriangle(
+        std::array<eng::vec::Vec4F, 3>{eng::vec::Vec4F{0, 0, -1, 1},
+                                       eng::vec::Vec4F{1, 0, -1, 1},
+                                       eng::vec::Vec4F{0, 1, -2, 1}},
+        planes);
+    CHECK(outside.size == 0);
+}
+
+TEST_CASE("Shared edge is clipped in the same point")
+{
+    eng::vec::Vec4F a{0.3f, 0.1f, -0.7f, 1.3f}, b{5.1f, 2.9f, 3.3f, 0.9f},
+        c{-1.7f, 4.3f, 2.1f, 1.1f}, d{4.9f, -3.1f, 1.7f, 1.7f};
+    std::array<eng::vec::Vec4F, 1> near{eng::vec::Vec4F{0, 0, 1, 0}};
+    auto first = clipTriangle(std::array{a, b, c}, near);
+    auto second = clipTriangle(std::array{b, a, d}, near);
+    auto onPlane = [](const auto &polygon) {
+        std::vector<eng::vec::Vec4F> result;
+        for (std::size_t i = 0; i < polygon.size; i++)
+            if (polygon.vertices[i].position[2] == 0)
+                result.push_back(polygon.vertices[i].position);
+        return result;
+    };
+    auto firstCut = onPlane(first), secondCut = onPlane(second);
+    REQUIRE(!firstCut.empty());
+    CHECK(std::find(secondCut.begin(), secondCut.end(), firstCut.front()) !=
+          secondCut.end());
+}
+
+TEST_CASE("Box outside of one of planes")
+{
+    std::array<eng::floating, 6> box{0, 1, 0, 1, 0, 1};
+    std::array<eng::vec::Vec4F, 2> planes{eng::vec::Vec4F{1, 0, 0, 0},
+                                          eng::vec::Vec4F{0, -1, 0, 2}};
+    CHECK(!isBoxOutside(box, planes));
+    // touches plane x = 0 from outside
+    CHECK(!isBoxOutside(std::array<eng::floating, 6>{-1, 0, 0, 1, 0, 1},
+                        planes));
+    CHECK(isBoxOutside(std::array<eng::floating, 6>{-2, -1, 0, 1, 0, 1},
+                       planes));
+    CHECK(isBoxOutside(std::array<eng::floating, 6>{0, 1, 3, 4, 0, 1},
+                       planes));
+}
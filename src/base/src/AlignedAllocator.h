@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace eng {
+
+// allocator for containers whose storage has to start at Alignment boundary,
+// e.g. at cache line
+template <typename T, std::size_t Alignment> struct AlignedAllocator {
+    static_assert(Alignment >= alignof(T) &&
+                      (Alignment & (Alignment - 1)) == 0,
+                  "alignment is power of two not less than one of type");
+
+    using value_type = T;
+    template <typename U> struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept
+    {}
+
+    [[nodiscard]] T *allocate(std::size_t count)
+    {
+        return static_cast<T *>(::operator new(
+            count * sizeof(T), std::align_val_t{Alignment}));
+    }
+    void deallocate(T *pointer, std::size_t) noexcept
+    {
+        ::operator delete(pointer, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept
+    {
+        return true;
+    }
+};
+
+inline constexpr std::size_t cacheLineSize = 64;
+
+} // namespace eng
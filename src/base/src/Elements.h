@@ -1,7 +1,10 @@
 #pragma once
 
 #include "../../vector/src/DimensionalVector.h"
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <vector>
 
 namespace eng {
@@ -10,6 +13,9 @@ using Vertex = vec::Vec4F;
 using Normal = vec::Vec3F;
 using TextureCoord = vec::Vec3F;
 using ScreenPixel = vec::Vec3<uint8_t>;
+// rows of inverse transposed 3x3 part of model matrix, it turns normals of
+// model to world space
+using NormalMatrix = std::array<Normal, 3>;
 
 struct PolygonComponent {
     constexpr static ssize_t invalidOffset = -1;
@@ -29,7 +35,41 @@ struct PolygonIndexes {
     integral textureCoordinatesIndex;
 };
 
+// coordinates of vertices as structure of arrays, i-th vertex is
+// {x[i], y[i], z[i], w[i]}
+struct VertexStreams {
+    std::vector<floating> x, y, z, w;
+};
+
 using Polygon = std::vector<PolygonComponent>; // or pointer
-using Triangle = std::array<PolygonComponent, 3>;
+// triangle of OBJ file, every attribute of corner has its own offset
+using Face = std::array<PolygonComponent, 3>;
+// indexes of vertices of welded model, i-th vertex has every attribute at
+// index i
+using Triangle = std::array<uint32_t, 3>;
+// index which no vertex has
+inline constexpr uint32_t noVertex = std::numeric_limits<uint32_t>::max();
+
+// pixels shaded together, lane i is i-th pixel of packet
+inline constexpr std::size_t packetSize = 8;
+using PacketValues = std::array<floating, packetSize>;
+
+// 3d vectors of packet as structure of arrays, i-th one is
+// {x[i], y[i], z[i]}
+struct PacketVec3 {
+    PacketValues x, y, z;
+};
+
+/*
+ * Pixels of one triangle in row, lane i is pixel (x + i, y) and is covered if
+ * bit i of mask is set. Barycentric coordinates of lanes out of mask are
+ * unspecified.
+ */
+struct PixelPacket {
+    uint32_t x, y;
+    uint32_t mask;
+    PacketValues u, v, w;
+    Triangle triangle;
+};
 
 } // namespace eng
@@ -0,0 +1,50 @@
+#include "MappedFile.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace eng {
+
+MappedFile::MappedFile(std::string_view path) : _data{nullptr}, _size{0}
+{
+    std::string name{path};
+    auto descriptor = ::open(name.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        throw std::system_error{errno, std::generic_category(),
+                                "Can't open " + name};
+    struct stat status {};
+    if (::fstat(descriptor, &status) < 0) {
+        auto error = errno;
+        ::close(descriptor);
+        throw std::system_error{error, std::generic_category(),
+                                "Can't get size of " + name};
+    }
+    _size = static_cast<std::size_t>(status.st_size);
+    if (_size != 0) {
+        auto mapping =
+            ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            auto error = errno;
+            ::close(descriptor);
+            throw std::system_error{error, std::generic_category(),
+                                    "Can't map " + name};
+        }
+        // file is read once from begin to end
+        ::madvise(mapping, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const char *>(mapping);
+    }
+    // mapping stays valid after descriptor is closed
+    ::close(descriptor);
+}
+
+MappedFile::~MappedFile()
+{
+    if (_data)
+        ::munmap(const_cast<char *>(_data), _size);
+}
+
+} // namespace eng
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace eng {
+
+/*
+ * Read only memory mapping of the whole file, pages are read by the system
+ * on first access. Throws std::system_error if file can't be opened or
+ * mapped. Empty file gives empty view.
+ */
+class MappedFile final {
+public:
+    explicit MappedFile(std::string_view path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] std::string_view view() const noexcept
+    {
+        return {_data, _size};
+    }
+
+private:
+    const char *_data;
+    std::size_t _size;
+};
+
+} // namespace eng
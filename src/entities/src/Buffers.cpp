@@ -22,17 +22,20 @@ bool PixelArray::trySetPixel(uint64_t index, pixel value)
 
 PixelArray::pixel &PixelArray::operator[](uint64_t index) { return pixels[index]; }
 
-void IndexBuffer::operator()(uint32_t x, uint32_t y, floating u, floating v, floating w,
-                             Triangle triangle) noexcept
+void VisibilityBuffer::operator()(uint32_t x, uint32_t y, floating u,
+                                  floating v, uint32_t triangle) noexcept
 {
-    uint64_t index = y * _xSize + x;
-    if (index < _gBuffer.size()) [[likely]] {
-        _gBuffer[index] = Fragment{u, v, w, triangle};
+    auto index = std::size_t{y} * _xSize + x;
+    if (index < _triangles.size()) [[likely]] {
+        _triangles[index] = triangle;
+        _u[index] = u;
+        _v[index] = v;
     }
 }
 
-void IndexBuffer::clean(){
-    std::fill(_gBuffer.begin(), _gBuffer.end(), Fragment{});
+void VisibilityBuffer::clean()
+{
+    std::fill(_triangles.begin(), _triangles.end(), noTriangle);
 }
 
 }
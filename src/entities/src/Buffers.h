@@ -4,6 +4,7 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <vector>
 
 namespace eng::ent {
@@ -31,29 +32,54 @@ public:
 private:
     std::vector<pixel> pixels;
 };
-struct Fragment {
-    floating u{}, v{}, w{};
-    Triangle triangle{};
-};
-
-
-// it can be used as z-buffer, but effectiveness should be tested
-class IndexBuffer{
+/*
+ * Visible triangle of every pixel for deferred shading: index of triangle
+ * in model and screen space barycentric coordinates u and v, w is
+ * 1 - u - v. Indexes and coordinates are separate arrays, so clean() writes
+ * only indexes.
+ */
+class VisibilityBuffer {
 public:
-    IndexBuffer(std::size_t gBufferSize, uint32_t xSize)
-        : _gBuffer(gBufferSize),_xSize(xSize)
+    static constexpr uint32_t noTriangle = std::numeric_limits<uint32_t>::max();
+
+    VisibilityBuffer(std::size_t size, uint32_t xSize)
+        : _triangles(size, noTriangle), _u(size), _v(size), _xSize(xSize)
     {}
-    IndexBuffer(const IndexBuffer &) = delete;
-    IndexBuffer&operator=(const IndexBuffer&) = delete;
-    [[nodiscard]] inline auto cBegin()const noexcept{return _gBuffer.cbegin();}
-    [[nodiscard]] inline auto cEnd()const noexcept{return _gBuffer.cend();}
+    VisibilityBuffer(const VisibilityBuffer &) = delete;
+    VisibilityBuffer &operator=(const VisibilityBuffer &) = delete;
+
     void clean();
 
-    void operator()(uint32_t x, uint32_t y, floating u, floating v, floating w,
-                    Triangle triangle) noexcept;
+    void operator()(uint32_t x, uint32_t y, floating u, floating v,
+                    uint32_t triangle) noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return _triangles.size();
+    }
+    [[nodiscard]] uint32_t xSize() const noexcept { return _xSize; }
+
+    // calls f(pixel, u, v, w, triangle) for every pixel which has triangle
+    template <typename F> void forEachVisible(F &&f) const
+    {
+        forEachVisible(0, _triangles.size(), f);
+    }
+    // the same for pixels with indexes in [first, last)
+    template <typename F>
+    void forEachVisible(std::size_t first, std::size_t last, F &&f) const
+    {
+        for (auto pixel = first; pixel < last; pixel++) {
+            auto triangle = _triangles[pixel];
+            if (triangle == noTriangle)
+                continue;
+            auto u = _u[pixel], v = _v[pixel];
+            f(pixel, u, v, 1 - u - v, triangle);
+        }
+    }
 
 private:
-    std::vector<Fragment> _gBuffer;
+    std::vector<uint32_t> _triangles;
+    std::vector<floating> _u, _v;
     uint32_t _xSize;
 };
 
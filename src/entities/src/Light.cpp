@@ -0,0 +1,297 @@
+#include "Light.h"
+#include <bit>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ENG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace eng::ent {
+
+namespace {
+
+#ifdef ENG_X86_KERNELS
+
+/*
+ * Lanes are computed by the same operations in the same order as per point
+ * shading does: sums are accumulated from zero, there is no fused
+ * multiply-add, square root and division are exact, so results are equal
+ * bit by bit. Lanes facing away from light add zero, which keeps sums.
+ */
+
+struct Vec3AVX2 {
+    __m256 x, y, z;
+};
+
+__attribute__((target("avx2"))) Vec3AVX2
+loadAVX2(const PacketVec3 &packet) noexcept
+{
+    return {_mm256_loadu_ps(packet.x.data()), _mm256_loadu_ps(packet.y.data()),
+            _mm256_loadu_ps(packet.z.data())};
+}
+
+__attribute__((target("avx2"))) void addAVX2(PacketValues &to,
+                                             __m256 value) noexcept
+{
+    _mm256_storeu_ps(to.data(),
+                     _mm256_add_ps(_mm256_loadu_ps(to.data()), value));
+}
+
+__attribute__((target("avx2"))) __m256 dotAVX2(Vec3AVX2 a,
+                                               Vec3AVX2 b) noexcept
+{
+    auto sum = _mm256_add_ps(_mm256_setzero_ps(), _mm256_mul_ps(a.x, b.x));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(a.y, b.y));
+    return _mm256_add_ps(sum, _mm256_mul_ps(a.z, b.z));
+}
+
+__attribute__((target("avx2"))) Vec3AVX2 normalizeAVX2(Vec3AVX2 v) noexcept
+{
+    auto length = _mm256_sqrt_ps(dotAVX2(v, v));
+    return {_mm256_div_ps(v.x, length), _mm256_div_ps(v.y, length),
+            _mm256_div_ps(v.z, length)};
+}
+
+// (color[k] * factor) * by[k] as in modulation of per point shading
+__attribute__((target("avx2"))) Vec3AVX2 modulateAVX2(vec::Vec3F color,
+                                                      __m256 factor,
+                                                      Vec3AVX2 by) noexcept
+{
+    return {_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(color[0]), factor), by.x),
+            _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(color[1]), factor), by.y),
+            _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(color[2]), factor),
+                          by.z)};
+}
+
+__attribute__((target("avx2"))) void
+accumulateAVX2(PacketVec3 &to, Vec3AVX2 value, __m256 mask,
+               const __m256 *attenuation) noexcept
+{
+    if (attenuation) {
+        value.x = _mm256_div_ps(value.x, *attenuation);
+        value.y = _mm256_div_ps(value.y, *attenuation);
+        value.z = _mm256_div_ps(value.z, *attenuation);
+    }
+    addAVX2(to.x, _mm256_and_ps(mask, value.x));
+    addAVX2(to.y, _mm256_and_ps(mask, value.y));
+    addAVX2(to.z, _mm256_and_ps(mask, value.z));
+}
+
+// pixels of packet, view vectors are from them to camera
+struct PacketShading {
+    const PacketVec3 &point, &normal, &albedo, &specular;
+    PacketVec3 view;
+    floating shine;
+    const SpecularPower &power;
+};
+
+// the same clamping and operations as SpecularPower::operator() does
+__attribute__((target("avx2"))) __m256
+approximatedPowerAVX2(const SpecularPower &power, __m256 cosine,
+                      floating shine) noexcept
+{
+    cosine = _mm256_max_ps(cosine, _mm256_setzero_ps());
+    cosine = _mm256_min_ps(cosine, _mm256_set1_ps(1));
+    if (power.getMode() == SpecularMode::Schlick) {
+        auto n = _mm256_set1_ps(shine);
+        return _mm256_div_ps(
+            cosine,
+            _mm256_add_ps(_mm256_sub_ps(n, _mm256_mul_ps(n, cosine)), cosine));
+    }
+    auto position = _mm256_mul_ps(
+        cosine, _mm256_set1_ps(static_cast<floating>(SpecularPower::tableSize)));
+    auto index = _mm256_cvttps_epi32(position);
+    auto fraction = _mm256_sub_ps(position, _mm256_cvtepi32_ps(index));
+    auto low = _mm256_i32gather_ps(power.table(), index, sizeof(floating));
+    auto high = _mm256_i32gather_ps(power.table() + 1, index, sizeof(floating));
+    return _mm256_add_ps(low,
+                         _mm256_mul_ps(_mm256_sub_ps(high, low), fraction));
+}
+
+__attribute__((target("avx2"))) void
+viewVectorsAVX2(const PacketVec3 &point, vec::Vec3F cameraPosition,
+                PacketVec3 &view) noexcept
+{
+    auto from = loadAVX2(point);
+    auto vector = normalizeAVX2(
+        {_mm256_sub_ps(_mm256_set1_ps(cameraPosition[0]), from.x),
+         _mm256_sub_ps(_mm256_set1_ps(cameraPosition[1]), from.y),
+         _mm256_sub_ps(_mm256_set1_ps(cameraPosition[2]), from.z)});
+    _mm256_storeu_ps(view.x.data(), vector.x);
+    _mm256_storeu_ps(view.y.data(), vector.y);
+    _mm256_storeu_ps(view.z.data(), vector.z);
+}
+
+// diffuse and specular terms of light from direction, attenuation is
+// nullptr for distant light
+__attribute__((target("avx2"))) void
+addLitAVX2(LightArray::PacketIntensities &result, const PacketShading &shading,
+           vec::Vec3F color, Vec3AVX2 direction,
+           const __m256 *attenuation) noexcept
+{
+    auto normal = loadAVX2(shading.normal);
+    auto normalLightDot = dotAVX2(normal, direction);
+    auto lit =
+        _mm256_cmp_ps(normalLightDot, _mm256_setzero_ps(), _CMP_GT_OQ);
+    auto litLanes = static_cast<uint32_t>(_mm256_movemask_ps(lit));
+    if (litLanes == 0)
+        return;
+    auto twice = _mm256_mul_ps(_mm256_set1_ps(2), normalLightDot);
+    auto reflect = normalizeAVX2(
+        {_mm256_sub_ps(direction.x, _mm256_mul_ps(normal.x, twice)),
+         _mm256_sub_ps(direction.y, _mm256_mul_ps(normal.y, twice)),
+         _mm256_sub_ps(direction.z, _mm256_mul_ps(normal.z, twice))});
+    auto shineDot = dotAVX2(reflect, loadAVX2(shading.view));
+    __m256 specularValue;
+    if (shading.power.isApproximated(shading.shine)) {
+        specularValue =
+            approximatedPowerAVX2(shading.power, shineDot, shading.shine);
+    } else {
+        PacketValues dots, values{};
+        _mm256_storeu_ps(dots.data(), shineDot);
+        for (; litLanes != 0; litLanes &= litLanes - 1) {
+            auto lane = static_cast<std::size_t>(std::countr_zero(litLanes));
+            values[lane] = std::pow(dots[lane], shading.shine);
+        }
+        specularValue = _mm256_loadu_ps(values.data());
+    }
+    accumulateAVX2(result.diffuse,
+                   modulateAVX2(color, normalLightDot,
+                                loadAVX2(shading.albedo)),
+                   lit, attenuation);
+    accumulateAVX2(result.specular,
+                   modulateAVX2(color, specularValue,
+                                loadAVX2(shading.specular)),
+                   lit, attenuation);
+}
+
+__attribute__((target("avx2"))) void
+addDistantAVX2(LightArray::PacketIntensities &result,
+               const PacketShading &shading, vec::Vec3F color,
+               floating ambientIntensity, vec::Vec3F direction) noexcept
+{
+    auto all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    accumulateAVX2(result.ambient,
+                   modulateAVX2(color, _mm256_set1_ps(ambientIntensity),
+                                loadAVX2(shading.albedo)),
+                   all, nullptr);
+    addLitAVX2(result, shading, color,
+               {_mm256_set1_ps(direction[0]), _mm256_set1_ps(direction[1]),
+                _mm256_set1_ps(direction[2])},
+               nullptr);
+}
+
+__attribute__((target("avx2"))) void
+addPointAVX2(LightArray::PacketIntensities &result,
+             const PacketShading &shading, vec::Vec3F color,
+             floating ambientIntensity, vec::Vec3F position,
+             floating constantAttenuation, floating linearAttenuation,
+             floating expAttenuation) noexcept
+{
+    auto point = loadAVX2(shading.point);
+    Vec3AVX2 direction{_mm256_sub_ps(_mm256_set1_ps(position[0]), point.x),
+                       _mm256_sub_ps(_mm256_set1_ps(position[1]), point.y),
+                       _mm256_sub_ps(_mm256_set1_ps(position[2]), point.z)};
+    auto distance = _mm256_sqrt_ps(dotAVX2(direction, direction));
+    auto attenuation = _mm256_add_ps(
+        _mm256_add_ps(_mm256_set1_ps(constantAttenuation),
+                      _mm256_mul_ps(_mm256_set1_ps(linearAttenuation),
+                                    distance)),
+        _mm256_mul_ps(
+            _mm256_mul_ps(_mm256_set1_ps(expAttenuation), distance),
+            distance));
+    auto all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    accumulateAVX2(result.ambient,
+                   modulateAVX2(color, _mm256_set1_ps(ambientIntensity),
+                                loadAVX2(shading.albedo)),
+                   all, &attenuation);
+    addLitAVX2(result, shading, color, normalizeAVX2(direction),
+               &attenuation);
+}
+
+#endif
+
+} // namespace
+
+template <typename ForEachPoint>
+LightArray::PacketIntensities LightArray::calculatePacket(
+    const PacketVec3 &inPoint, const PacketVec3 &withNormal,
+    const PacketVec3 &albedo, const PacketVec3 &specular,
+    vec::Vec3F cameraPosition, floating shine,
+    ForEachPoint &&forEachPoint) const noexcept
+{
+    PacketIntensities result{};
+#ifdef ENG_X86_KERNELS
+    static const bool vectorized = __builtin_cpu_supports("avx2");
+    if (vectorized) {
+        PacketShading shading{inPoint, withNormal, albedo, specular, {},
+                              shine, _specularPower};
+        viewVectorsAVX2(inPoint, cameraPosition, shading.view);
+        for (std::size_t i = 0; i < _distant.color.size(); i++)
+            addDistantAVX2(result, shading, _distant.color[i],
+                           _distant.ambientIntensity[i],
+                           _distant.direction[i]);
+        forEachPoint([&](std::size_t i) {
+            addPointAVX2(result, shading, _point.color[i],
+                         _point.ambientIntensity[i], _point.position[i],
+                         _point.constantAttenuation[i],
+                         _point.linearAttenuation[i],
+                         _point.expAttenuation[i]);
+        });
+        return result;
+    }
+#endif
+    for (std::size_t lane = 0; lane < packetSize; lane++) {
+        vec::Vec3F point{inPoint.x[lane], inPoint.y[lane], inPoint.z[lane]};
+        vec::Vec3F normal{withNormal.x[lane], withNormal.y[lane],
+                          withNormal.z[lane]};
+        vec::Vec3F albedoValue{albedo.x[lane], albedo.y[lane], albedo.z[lane]};
+        vec::Vec3F specularValue{specular.x[lane], specular.y[lane],
+                                 specular.z[lane]};
+        Intensities intensities{};
+        auto viewVector = (cameraPosition - point).normalize();
+        addDistant(intensities, normal, albedoValue, specularValue, viewVector,
+                   shine);
+        forEachPoint([&](std::size_t i) {
+            addPoint(intensities, i, point, normal, albedoValue, specularValue,
+                     viewVector, shine);
+        });
+        for (auto [to, from] :
+             {std::pair{&result.ambient, &intensities.ambient},
+              std::pair{&result.diffuse, &intensities.diffuse},
+              std::pair{&result.specular, &intensities.specular}}) {
+            to->x[lane] = (*from)[0];
+            to->y[lane] = (*from)[1];
+            to->z[lane] = (*from)[2];
+        }
+    }
+    return result;
+}
+
+LightArray::PacketIntensities LightArray::calculatePhongColor(
+    const PacketVec3 &inPoint, const PacketVec3 &withNormal,
+    const PacketVec3 &albedo, const PacketVec3 &specular,
+    vec::Vec3F cameraPosition, floating shine) const noexcept
+{
+    return calculatePacket(inPoint, withNormal, albedo, specular,
+                           cameraPosition, shine, [this](auto &&add) {
+                               for (std::size_t i = 0; i < _point.color.size();
+                                    i++)
+                                   add(i);
+                           });
+}
+
+LightArray::PacketIntensities LightArray::calculatePhongColor(
+    const PacketVec3 &inPoint, const PacketVec3 &withNormal,
+    const PacketVec3 &albedo, const PacketVec3 &specular,
+    vec::Vec3F cameraPosition, floating shine,
+    std::span<const uint32_t> pointLights) const noexcept
+{
+    return calculatePacket(inPoint, withNormal, albedo, specular,
+                           cameraPosition, shine, [pointLights](auto &&add) {
+                               for (auto i : pointLights)
+                                   add(i);
+                           });
+}
+
+} // namespace eng::ent
@@ -1,113 +1,272 @@
 #pragma once
 
+#include "../../base/src/Elements.h"
 #include "../../vector/src/DimensionalVector.h"
+#include "SpecularPower.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
 
 namespace eng::ent {
-// TODO rewrite without dynamic polymorphism
-class Light{
+
+struct DistantLight {
+    DistantLight(vec::Vec3F d, vec::Vec3F c, floating i)
+        : color(c), direction{d}, ambientIntensity(i)
+    {}
+    vec::Vec3F color{0xFF, 0xFF, 0xFF};
+    // to rotate mul on rotation matrix
+    vec::Vec3F direction{0, 0, 1};
+    floating ambientIntensity{0.2f};
+};
+
+struct PointLight {
+    PointLight(vec::Vec3F p, vec::Vec3F c, floating i, floating ca,
+               floating la, floating ea)
+        : color(c), position(p), ambientIntensity(i), constantAttenuation(ca),
+          linearAttenuation(la), expAttenuation(ea)
+    {}
+    vec::Vec3F color{0xFF, 0xFF, 0xFF};
+    vec::Vec3F position{0, 0, 1};
+    floating ambientIntensity{0.2f};
+    floating constantAttenuation;
+    floating linearAttenuation;
+    floating expAttenuation;
+};
+
+/*
+ * Lights are stored by type, every type as structure of arrays, and all
+ * lights of one type are evaluated in one loop without dynamic dispatch.
+ * Lights of one type are summed in order they were added.
+ *
+ * Point light has radius of influence, out of it every channel of its
+ * ambient, diffuse and specular intensity is less than negligibleIntensity
+ * for any albedo, specular property and normal in [0, 1].
+ */
+class LightArray {
 public:
-    struct Intensities{
+    static constexpr floating negligibleIntensity = 0.25f;
+
+    struct Intensities {
         vec::Vec3F ambient;
         vec::Vec3F diffuse;
         vec::Vec3F specular;
     };
-    [[nodiscard]] virtual Intensities calculatePhongColor(vec::Vec3F inPoint, vec::Vec3F withNormal, vec::Vec3F albedo, vec::Vec3F specular, vec::Vec3F cameraPosition,   floating shine)const noexcept = 0;
-    virtual ~Light() = default;
-};
-using LightArray = std::vector<std::unique_ptr<Light>>;
 
-struct DistantLight final : Light{
-public:
-    [[nodiscard]] inline Intensities calculatePhongColor(vec::Vec3F inPoint, vec::Vec3F withNormal,  vec::Vec3F albedo, vec::Vec3F specular, vec::Vec3F cameraPosition, floating shine)const noexcept override{
+    struct PacketIntensities {
+        PacketVec3 ambient;
+        PacketVec3 diffuse;
+        PacketVec3 specular;
+    };
+
+    void push_back(const DistantLight &light)
+    {
+        _distant.color.push_back(light.color);
+        _distant.direction.push_back(light.direction);
+        _distant.ambientIntensity.push_back(light.ambientIntensity);
+    }
+
+    void push_back(const PointLight &light)
+    {
+        _point.color.push_back(light.color);
+        _point.position.push_back(light.position);
+        _point.ambientIntensity.push_back(light.ambientIntensity);
+        _point.constantAttenuation.push_back(light.constantAttenuation);
+        _point.linearAttenuation.push_back(light.linearAttenuation);
+        _point.expAttenuation.push_back(light.expAttenuation);
+        _point.radius.push_back(influenceRadius(light));
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return _distant.color.size() + _point.color.size();
+    }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    [[nodiscard]] std::size_t pointLightsCount() const noexcept
+    {
+        return _point.color.size();
+    }
+    [[nodiscard]] vec::Vec3F getPointLightPosition(std::size_t i) const
+    {
+        return _point.position[i];
+    }
+    // infinity for light without attenuation by distance
+    [[nodiscard]] floating getPointLightRadius(std::size_t i) const
+    {
+        return _point.radius[i];
+    }
+
+    // fast specular modes are used for shine the array is prepared for
+    [[nodiscard]] SpecularMode getSpecularMode() const noexcept
+    {
+        return _specularPower.getMode();
+    }
+    void setSpecularMode(SpecularMode newMode)
+    {
+        _specularPower.setMode(newMode);
+    }
+    void prepareSpecular(floating shine) { _specularPower.prepare(shine); }
+
+    // sum of Phong intensities of all lights in point
+    [[nodiscard]] Intensities
+    calculatePhongColor(vec::Vec3F inPoint, vec::Vec3F withNormal,
+                        vec::Vec3F albedo, vec::Vec3F specular,
+                        vec::Vec3F cameraPosition,
+                        floating shine) const noexcept
+    {
+        Intensities result{};
         auto viewVector = (cameraPosition - inPoint).normalize();
-        auto normalLightDot = withNormal * direction;
-        if(normalLightDot > 0){
-            auto reflectVector =
-                (direction - withNormal * (2 * (normalLightDot)))
-                    .normalize();
-            auto shineDot = reflectVector * viewVector;
-            auto specularValue = std::pow(shineDot, shine);
-            return Intensities{
-                {
-                    color[0] * ambientIntensity * albedo[0],
-                    color[1] * ambientIntensity * albedo[1],
-                    color[2] * ambientIntensity * albedo[2]
-                },
-                {
-                    color[0] * normalLightDot * albedo[0],
-                    color[1] * normalLightDot * albedo[1],
-                    color[2] * normalLightDot * albedo[2]
-                },
-                {
-                    color[0] * specularValue * specular[0],
-                    color[1] * specularValue * specular[1],
-                    color[2] * specularValue * specular[2],
-                }};
-        } else {
-            return Intensities{
-                {
-                    color[0] * ambientIntensity *albedo[0],
-                    color[1] * ambientIntensity *albedo[1],
-                    color[2] * ambientIntensity *albedo[2]
-                }, {}, {}
-            };
+        addDistant(result, withNormal, albedo, specular, viewVector, shine);
+        for (std::size_t i = 0; i < _point.color.size(); i++)
+            addPoint(result, i, inPoint, withNormal, albedo, specular,
+                     viewVector, shine);
+        return result;
+    }
+
+    // the same for all distant lights and only listed point lights, indexes
+    // are in order lights were added
+    [[nodiscard]] Intensities
+    calculatePhongColor(vec::Vec3F inPoint, vec::Vec3F withNormal,
+                        vec::Vec3F albedo, vec::Vec3F specular,
+                        vec::Vec3F cameraPosition, floating shine,
+                        std::span<const uint32_t> pointLights) const noexcept
+    {
+        Intensities result{};
+        auto viewVector = (cameraPosition - inPoint).normalize();
+        addDistant(result, withNormal, albedo, specular, viewVector, shine);
+        for (auto i : pointLights)
+            addPoint(result, i, inPoint, withNormal, albedo, specular,
+                     viewVector, shine);
+        return result;
+    }
+
+    /*
+     * Packet versions give for every lane the same result as per point ones.
+     * Lanes are shaded together by vector kernel if processor has AVX2 and
+     * one by one otherwise.
+     */
+    [[nodiscard]] PacketIntensities
+    calculatePhongColor(const PacketVec3 &inPoint, const PacketVec3 &withNormal,
+                        const PacketVec3 &albedo, const PacketVec3 &specular,
+                        vec::Vec3F cameraPosition,
+                        floating shine) const noexcept;
+    [[nodiscard]] PacketIntensities
+    calculatePhongColor(const PacketVec3 &inPoint, const PacketVec3 &withNormal,
+                        const PacketVec3 &albedo, const PacketVec3 &specular,
+                        vec::Vec3F cameraPosition, floating shine,
+                        std::span<const uint32_t> pointLights) const noexcept;
+
+private:
+    static vec::Vec3F modulate(vec::Vec3F color, floating intensity,
+                               vec::Vec3F by) noexcept
+    {
+        return {color[0] * intensity * by[0], color[1] * intensity * by[1],
+                color[2] * intensity * by[2]};
+    }
+
+    void addDistant(Intensities &result, vec::Vec3F withNormal,
+                    vec::Vec3F albedo, vec::Vec3F specular,
+                    vec::Vec3F viewVector, floating shine) const noexcept
+    {
+        for (std::size_t i = 0; i < _distant.color.size(); i++) {
+            auto color = _distant.color[i];
+            auto direction = _distant.direction[i];
+            result.ambient +=
+                modulate(color, _distant.ambientIntensity[i], albedo);
+            auto normalLightDot = withNormal * direction;
+            if (normalLightDot > 0) {
+                auto reflectVector =
+                    (direction - withNormal * (2 * (normalLightDot)))
+                        .normalize();
+                auto shineDot = reflectVector * viewVector;
+                auto specularValue = _specularPower(shineDot, shine);
+                result.diffuse += modulate(color, normalLightDot, albedo);
+                result.specular += modulate(color, specularValue, specular);
+            }
         }
     }
-    ~DistantLight() override = default;
-    DistantLight(vec::Vec3F d, vec::Vec3F c, floating i) : Light(), color(c), direction{d}, ambientIntensity(i){}
-    vec::Vec3F color{0xFF, 0xFF, 0xFF};
-    // to rotate mul on rotation matrix
-    vec::Vec3F direction{0, 0, 1};
-    floating ambientIntensity{0.2f};
-};
 
-struct PointLight final : Light{
-    [[nodiscard]] inline Intensities calculatePhongColor(vec::Vec3F inPoint, vec::Vec3F withNormal,  vec::Vec3F albedo, vec::Vec3F specular, vec::Vec3F cameraPosition, floating shine)const noexcept override{
-        auto direction = position - inPoint;
+    void addPoint(Intensities &result, std::size_t i, vec::Vec3F inPoint,
+                  vec::Vec3F withNormal, vec::Vec3F albedo,
+                  vec::Vec3F specular, vec::Vec3F viewVector,
+                  floating shine) const noexcept
+    {
+        auto color = _point.color[i];
+        auto direction = _point.position[i] - inPoint;
         auto distance = direction.length();
-        auto attenuation = constantAttenuation + linearAttenuation * distance + expAttenuation * distance * distance;
-        auto ambient = vec::Vec3F{
-            color[0] * ambientIntensity * albedo[0],
-            color[1] * ambientIntensity * albedo[1],
-            color[2] * ambientIntensity * albedo[2]
-        } / attenuation;
+        auto attenuation = _point.constantAttenuation[i] +
+                           _point.linearAttenuation[i] * distance +
+                           _point.expAttenuation[i] * distance * distance;
+        result.ambient +=
+            modulate(color, _point.ambientIntensity[i], albedo) / attenuation;
         direction.normalize();
         auto normalLightDot = withNormal * direction;
-        if(normalLightDot > 0){
-            auto viewVector = (cameraPosition - inPoint).normalize();
+        if (normalLightDot > 0) {
             auto reflectVector =
-                (direction - withNormal * (2 * (normalLightDot)))
-                    .normalize();
+                (direction - withNormal * (2 * (normalLightDot))).normalize();
             auto shineDot = reflectVector * viewVector;
-            auto specularValue = std::pow(shineDot, shine);
-            auto diffuse =
-                vec::Vec3F {
-                    color[0] * normalLightDot * albedo[0],
-                    color[1] * normalLightDot * albedo[1],
-                    color[2] * normalLightDot * albedo[2]
-                } / attenuation;
-            auto spec =
-            vec::Vec3F {
-                color[0] * specularValue * specular[0],
-                    color[1] * specularValue * specular[1],
-                    color[2] * specularValue * specular[2],
-            } / attenuation;
-            return {ambient, diffuse, spec};
-        } else {
-            return {ambient, {}, {}};
+            auto specularValue = _specularPower(shineDot, shine);
+            result.diffuse +=
+                modulate(color, normalLightDot, albedo) / attenuation;
+            result.specular +=
+                modulate(color, specularValue, specular) / attenuation;
         }
     }
-    PointLight( vec::Vec3F p,vec::Vec3F c, floating i, floating ca, floating la, floating ea)
-    : color(c), position(p), ambientIntensity(i), constantAttenuation(ca), linearAttenuation(la), expAttenuation(ea)
-    {}
-    ~PointLight() override = default;
-    vec::Vec3F color{0xFF, 0xFF, 0xFF};
-    vec::Vec3F position{0, 0, 1};
-    floating ambientIntensity{0.2f};
-    floating constantAttenuation;
-    floating linearAttenuation;
-    floating expAttenuation;
-};
 
+    /*
+     * Sum of intensities is at most max channel * (ambient + 2) divided by
+     * attenuation, diffuse and specular factors are at most 1. Radius is
+     * the distance from which attenuation makes it negligible.
+     */
+    static floating influenceRadius(const PointLight &light) noexcept
+    {
+        auto brightest =
+            std::max({light.color[0], light.color[1], light.color[2]});
+        auto limit =
+            brightest * (light.ambientIntensity + 2) / negligibleIntensity;
+        auto c = light.constantAttenuation - limit;
+        auto l = light.linearAttenuation;
+        auto e = light.expAttenuation;
+        if (c >= 0)
+            return 0;
+        if (e > 0)
+            return (-l + std::sqrt(l * l - 4 * e * c)) / (2 * e);
+        if (l > 0)
+            return -c / l;
+        return std::numeric_limits<floating>::infinity();
+    }
+
+    // forEachPoint calls its argument with index of every shaded point light
+    template <typename ForEachPoint>
+    [[nodiscard]] PacketIntensities
+    calculatePacket(const PacketVec3 &inPoint, const PacketVec3 &withNormal,
+                    const PacketVec3 &albedo, const PacketVec3 &specular,
+                    vec::Vec3F cameraPosition, floating shine,
+                    ForEachPoint &&forEachPoint) const noexcept;
+
+    struct DistantLights {
+        std::vector<vec::Vec3F> color;
+        std::vector<vec::Vec3F> direction;
+        std::vector<floating> ambientIntensity;
+    };
+
+    struct PointLights {
+        std::vector<vec::Vec3F> color;
+        std::vector<vec::Vec3F> position;
+        std::vector<floating> ambientIntensity;
+        std::vector<floating> constantAttenuation;
+        std::vector<floating> linearAttenuation;
+        std::vector<floating> expAttenuation;
+        std::vector<floating> radius;
+    };
+
+    DistantLights _distant;
+    PointLights _point;
+    SpecularPower _specularPower;
+};
 
-} // namespace eng::ent
\ No newline at end of file
+} // namespace eng::ent
@@ -0,0 +1,255 @@
+#include "MeshCache.h"
+#include "../../base/src/MappedFile.h"
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <type_traits>
+
+namespace eng::ent {
+
+namespace {
+
+static_assert(std::is_trivially_copyable_v<Normal> &&
+              std::is_trivially_copyable_v<TextureCoord> &&
+              std::is_trivially_copyable_v<Triangle>);
+
+// Model::Chunk as it's written, fields are laid out without padding, so no
+// byte of file is uninitialized memory
+struct StoredChunk {
+    uint64_t firstTriangle, lastTriangle;
+    uint64_t firstVertex, lastVertex;
+    Model::BoundingBox box;
+    vec::Vec3F center;
+    floating radius;
+    vec::Vec3F coneAxis;
+    floating coneCos, coneSin;
+    uint32_t reserved;
+};
+static_assert(std::is_trivially_copyable_v<StoredChunk> &&
+              sizeof(StoredChunk) == 4 * sizeof(uint64_t) +
+                                         15 * sizeof(floating) +
+                                         sizeof(uint32_t));
+
+StoredChunk toStored(const Model::Chunk &chunk) noexcept
+{
+    return {chunk.firstTriangle, chunk.lastTriangle, chunk.firstVertex,
+            chunk.lastVertex,    chunk.box,          chunk.center,
+            chunk.radius,        chunk.coneAxis,     chunk.coneCos,
+            chunk.coneSin,       0};
+}
+
+Model::Chunk fromStored(const StoredChunk &chunk) noexcept
+{
+    return {chunk.firstTriangle, chunk.lastTriangle, chunk.firstVertex,
+            chunk.lastVertex,    chunk.box,          chunk.center,
+            chunk.radius,        chunk.coneAxis,     chunk.coneCos,
+            chunk.coneSin};
+}
+
+constexpr std::array<char, 8> magic{'e', 'n', 'g', 'm', 'e', 's', 'h', '\0'};
+// every array starts at such offset in file
+constexpr std::size_t sectionAlignment = 64;
+
+// fields which have to match for cache to be used
+struct Key {
+    std::array<char, 8> magic;
+    uint32_t version;
+    std::array<uint32_t, 5> elementSizes;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+
+    bool operator==(const Key &) const = default;
+};
+
+// counts of vertices, normals, texture coordinates, triangles and chunks
+using Counts = std::array<uint64_t, 5>;
+
+struct Header {
+    Key key;
+    Counts counts;
+};
+// header is written as it is, so it has no padding either
+static_assert(sizeof(Key) == sizeof(magic) + sizeof(uint32_t) * 6 +
+                                 sizeof(uint64_t) + sizeof(int64_t) &&
+              sizeof(Header) == sizeof(Key) + sizeof(Counts));
+
+Key makeKey(std::string_view sourcePath)
+{
+    std::filesystem::path source{sourcePath};
+    Key key{magic,
+            meshCacheVersion,
+            {sizeof(floating), sizeof(Normal), sizeof(TextureCoord),
+             sizeof(Triangle), sizeof(StoredChunk)},
+            0,
+            0};
+    key.sourceSize = std::filesystem::file_size(source);
+    key.sourceTime =
+        std::filesystem::last_write_time(source).time_since_epoch().count();
+    return key;
+}
+
+constexpr std::size_t align(std::size_t offset)
+{
+    return (offset + sectionAlignment - 1) / sectionAlignment *
+           sectionAlignment;
+}
+
+// vertices are four arrays of coordinates, x, y, z and w
+constexpr std::size_t sectionsCount = 8;
+
+// offsets of arrays in file, the last one is size of file
+std::array<std::size_t, sectionsCount + 1> sectionOffsets(const Key &key,
+                                                         const Counts &counts)
+{
+    std::array<std::size_t, sectionsCount + 1> offsets{align(sizeof(Header))};
+    for (std::size_t i = 0; i < sectionsCount; i++) {
+        auto element = i < 4 ? 0 : i - 3;
+        offsets[i + 1] = align(offsets[i] +
+                               counts[element] * key.elementSizes[element]);
+    }
+    return offsets;
+}
+
+template <typename Element>
+std::vector<Element> readSection(std::string_view data, std::size_t offset,
+                                 uint64_t count)
+{
+    std::vector<Element> elements(count);
+    // empty vector may have no storage, which memcpy can't take
+    if (!elements.empty())
+        std::memcpy(elements.data(), data.data() + offset,
+                    elements.size() * sizeof(Element));
+    return elements;
+}
+
+template <typename Element>
+void writeSection(std::ofstream &file, const Element *elements,
+                  std::size_t count)
+{
+    file.write(reinterpret_cast<const char *>(elements),
+               static_cast<std::streamsize>(count * sizeof(Element)));
+    std::array<char, sectionAlignment> padding{};
+    auto end = static_cast<std::size_t>(file.tellp());
+    file.write(padding.data(), static_cast<std::streamsize>(align(end) - end));
+}
+
+} // namespace
+
+std::string meshCachePath(std::string_view sourcePath)
+{
+    return std::string{sourcePath} + ".meshcache";
+}
+
+bool loadMeshCache(std::string_view sourcePath, Model &model)
+{
+    auto path = meshCachePath(sourcePath);
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error))
+        return false;
+    // cache which can't be read is the same as missing one, source is parsed
+    std::optional<MappedFile> file;
+    try {
+        file.emplace(path);
+    } catch (const std::system_error &) {
+        return false;
+    }
+    auto data = file->view();
+    Header header{};
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.key != makeKey(sourcePath))
+        return false;
+    // counts of broken file can't overflow offsets
+    for (auto count : header.counts)
+        if (count > data.size())
+            return false;
+    auto offsets = sectionOffsets(header.key, header.counts);
+    if (data.size() != offsets.back())
+        return false;
+
+    const auto &counts = header.counts;
+    // attributes of welded vertices
+    for (auto count : {counts[1], counts[2]})
+        if (count != 0 && count != counts[0])
+            return false;
+    auto stored = readSection<StoredChunk>(data, offsets[7], counts[4]);
+    std::vector<Model::Chunk> chunks;
+    chunks.reserve(stored.size());
+    for (const auto &chunk : stored)
+        chunks.push_back(fromStored(chunk));
+    // chunks cover all triangles in order, and vertices of every triangle
+    // are in range of its chunk, so they're in model
+    auto triangles = readSection<Triangle>(data, offsets[6], counts[3]);
+    std::size_t covered = 0;
+    for (const auto &chunk : chunks) {
+        if (chunk.firstTriangle != covered ||
+            chunk.lastTriangle < chunk.firstTriangle ||
+            chunk.lastTriangle > triangles.size() ||
+            chunk.firstVertex > chunk.lastVertex ||
+            chunk.lastVertex > counts[0])
+            return false;
+        for (auto t = chunk.firstTriangle; t < chunk.lastTriangle; t++)
+            for (std::size_t vertex : triangles[t])
+                if (vertex < chunk.firstVertex || vertex >= chunk.lastVertex)
+                    return false;
+        covered = chunk.lastTriangle;
+    }
+    if (covered != counts[3])
+        return false;
+
+    model.reset({readSection<floating>(data, offsets[0], counts[0]),
+                 readSection<floating>(data, offsets[1], counts[0]),
+                 readSection<floating>(data, offsets[2], counts[0]),
+                 readSection<floating>(data, offsets[3], counts[0])},
+                std::move(triangles),
+                readSection<Normal>(data, offsets[4], counts[1]),
+                readSection<TextureCoord>(data, offsets[5], counts[2]),
+                std::move(chunks));
+    return true;
+}
+
+void saveMeshCache(std::string_view sourcePath, const Model &model)
+{
+    const auto &chunks = model.getChunks();
+    Header header{makeKey(sourcePath),
+                  {model.verticesCount(),
+                   static_cast<uint64_t>(model.normalsEnd() -
+                                         model.normalsBegin()),
+                   static_cast<uint64_t>(model.textureCoordsEnd() -
+                                         model.textureCoordsBegin()),
+                   static_cast<uint64_t>(model.trianglesEnd() -
+                                         model.trianglesBegin()),
+                   chunks.size()}};
+
+    auto path = meshCachePath(sourcePath);
+    auto temporaryPath = path + ".tmp";
+    {
+        std::ofstream file;
+        file.exceptions(std::ios::failbit | std::ios::badbit);
+        file.open(temporaryPath, std::ios::binary | std::ios::trunc);
+        writeSection(file, &header, 1);
+        const auto &positions = model.getPositions();
+        for (const auto *stream :
+             {&positions.x, &positions.y, &positions.z, &positions.w})
+            writeSection(file, stream->data(), stream->size());
+        writeSection(file, std::to_address(model.normalsBegin()),
+                     header.counts[1]);
+        writeSection(file, std::to_address(model.textureCoordsBegin()),
+                     header.counts[2]);
+        writeSection(file, std::to_address(model.trianglesBegin()),
+                     header.counts[3]);
+        std::vector<StoredChunk> stored;
+        stored.reserve(chunks.size());
+        for (const auto &chunk : chunks)
+            stored.push_back(toStored(chunk));
+        writeSection(file, stored.data(), stored.size());
+    }
+    std::filesystem::rename(temporaryPath, path);
+}
+
+} // namespace eng::ent
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Model.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace eng::ent {
+
+/*
+ * Binary copy of geometry of model which is kept next to its source file.
+ * Header holds size and modification time of source, so cache of changed
+ * source is stale, and sizes of element types, so cache written by build
+ * with other layout isn't read. Then streams of vertex coordinates, normals,
+ * texture coordinates, triangles ordered by chunks and chunks themselves
+ * follow as they're laid out in memory, chunks without padding, so loading
+ * is copying of mapped arrays to model without parsing and building of
+ * chunks.
+ */
+constexpr uint32_t meshCacheVersion = 3;
+
+[[nodiscard]] std::string meshCachePath(std::string_view sourcePath);
+
+// false if there's no cache for source, it's stale or it can't be read,
+// model isn't changed then
+bool loadMeshCache(std::string_view sourcePath, Model &model);
+
+// cache is written to temporary file which replaces the old one, so it's
+// never read half written; throws std::system_error if it can't be written
+void saveMeshCache(std::string_view sourcePath, const Model &model);
+
+} // namespace eng::ent
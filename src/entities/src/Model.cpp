@@ -1,4 +1,8 @@
 #include "Model.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 
 namespace eng::ent {
 
@@ -7,14 +11,222 @@ void Model::reset(std::vector<Vertex> &&vertices,
                   std::vector<Normal> &&normals,
                   std::vector<TextureCoord> &&textureCoords)
 {
-    _vertices = std::move(vertices);
+    _positions = {};
+    appendPositions(vertices);
     _triangles = std::move(polygons);
     _normals = std::move(normals);
     _textureCoords = std::move(textureCoords);
+    _chunks.clear();
+    buildChunks(0, 0);
+    _worldVertices.clear();
+    _worldNormals.clear();
+    _version++;
 }
+
+void Model::reset(VertexStreams &&positions,
+                  std::vector<Triangle> &&polygons,
+                  std::vector<Normal> &&normals,
+                  std::vector<TextureCoord> &&textureCoords,
+                  std::vector<Chunk> &&chunks)
+{
+    _positions = std::move(positions);
+    _triangles = std::move(polygons);
+    _normals = std::move(normals);
+    _textureCoords = std::move(textureCoords);
+    _chunks = std::move(chunks);
+    // every triangle is in chunk already, so only bounding box is found
+    buildChunks(0, _triangles.size());
+    _worldVertices.clear();
+    _worldNormals.clear();
+    _version++;
+}
+
+void Model::append(std::vector<Vertex> &&vertices,
+                   std::vector<Triangle> &&polygons,
+                   std::vector<Normal> &&normals,
+                   std::vector<TextureCoord> &&textureCoords)
+{
+    auto firstVertex = verticesCount();
+    auto firstTriangle = _triangles.size();
+    auto appendAttributes = [&](auto &attributes, const auto &added) {
+        if (attributes.empty() && added.empty())
+            return;
+        attributes.resize(firstVertex);
+        attributes.insert(attributes.end(), added.cbegin(), added.cend());
+        attributes.resize(firstVertex + vertices.size());
+    };
+    appendAttributes(_normals, normals);
+    appendAttributes(_textureCoords, textureCoords);
+    appendPositions(vertices);
+    _triangles.insert(_triangles.end(), polygons.cbegin(), polygons.cend());
+    buildChunks(firstVertex, firstTriangle);
+    _version++;
+}
+
+void Model::appendPositions(const std::vector<Vertex> &vertices)
+{
+    auto streams = std::array{&_positions.x, &_positions.y, &_positions.z,
+                              &_positions.w};
+    for (std::size_t k = 0; k < streams.size(); k++) {
+        auto &stream = *streams[k];
+        stream.reserve(stream.size() + vertices.size());
+        for (const auto &vertex : vertices)
+            stream.push_back(vertex[k]);
+    }
+}
+
+void Model::buildChunks(std::size_t firstVertex, std::size_t firstTriangle)
+{
+    if (firstVertex == 0)
+        _boundingBox = {};
+    if (firstVertex < verticesCount()) {
+        auto streams = std::array{&_positions.x, &_positions.y, &_positions.z};
+        for (std::size_t i = 0; i < 3; i++) {
+            auto [min, max] = std::minmax_element(
+                streams[i]->cbegin() + static_cast<std::ptrdiff_t>(firstVertex),
+                streams[i]->cend());
+            _boundingBox[i * 2] = firstVertex == 0
+                                      ? *min
+                                      : std::min(*min, _boundingBox[i * 2]);
+            _boundingBox[i * 2 + 1] =
+                firstVertex == 0 ? *max
+                                 : std::max(*max, _boundingBox[i * 2 + 1]);
+        }
+    }
+    // only triangles from firstTriangle are split on chunks, indexes below
+    // are relative to it
+    auto trianglesCount = _triangles.size() - firstTriangle;
+    if (trianglesCount == 0)
+        return;
+    const auto *triangles = _triangles.data() + firstTriangle;
+
+    // triangles of every vertex which new triangles refer to, appended
+    // triangles refer to vertices near the end, so it isn't the whole model
+    std::size_t low = verticesCount(), high = 0;
+    for (std::size_t t = 0; t < trianglesCount; t++)
+        for (std::size_t vertex : triangles[t]) {
+            low = std::min(low, vertex);
+            high = std::max(high, vertex);
+        }
+    std::vector<std::size_t> offsets(high - low + 2);
+    for (std::size_t t = 0; t < trianglesCount; t++)
+        for (std::size_t vertex : triangles[t])
+            offsets[vertex - low + 1]++;
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<std::size_t> adjacent(offsets.back());
+    auto ends = offsets;
+    for (std::size_t t = 0; t < trianglesCount; t++)
+        for (std::size_t vertex : triangles[t])
+            adjacent[ends[vertex - low]++] = t;
+
+    // chunk grows by breadth-first walk over shared vertices from the first
+    // triangle which isn't taken yet, so it's a connected patch of surface
+    std::vector<Triangle> ordered;
+    ordered.reserve(trianglesCount);
+    std::vector<bool> taken(trianglesCount);
+    std::vector<std::size_t> queue;
+    auto firstChunk = _chunks.size();
+    for (std::size_t seed = 0; ordered.size() < trianglesCount; seed++) {
+        if (taken[seed])
+            continue;
+        queue.assign(1, seed);
+        taken[seed] = true;
+        auto first = ordered.size();
+        std::size_t head = 0;
+        for (; head < queue.size() && ordered.size() - first < chunkSize;
+             head++) {
+            const auto &triangle = triangles[queue[head]];
+            ordered.push_back(triangle);
+            for (std::size_t vertex : triangle) {
+                vertex -= low;
+                for (auto i = offsets[vertex]; i < offsets[vertex + 1]; i++) {
+                    if (!taken[adjacent[i]]) {
+                        taken[adjacent[i]] = true;
+                        queue.push_back(adjacent[i]);
+                    }
+                }
+            }
+        }
+        // queued triangles which didn't fit are left for next chunks
+        for (; head < queue.size(); head++)
+            taken[queue[head]] = false;
+        _chunks.push_back({firstTriangle + first,
+                           firstTriangle + ordered.size(), 0, 0, {}, {}, 0,
+                           {}, 0, 0});
+    }
+    std::copy(ordered.cbegin(), ordered.cend(),
+              _triangles.begin() + static_cast<std::ptrdiff_t>(firstTriangle));
+
+    for (auto chunk = _chunks.begin() + static_cast<std::ptrdiff_t>(firstChunk);
+         chunk != _chunks.end(); chunk++)
+        computeChunkBounds(*chunk);
+}
+
+void Model::computeChunkBounds(Chunk &chunk) const noexcept
+{
+    chunk.firstVertex = verticesCount();
+    chunk.lastVertex = 0;
+    for (std::size_t i = 0; i < 3; i++) {
+        chunk.box[i * 2] = std::numeric_limits<floating>::max();
+        chunk.box[i * 2 + 1] = std::numeric_limits<floating>::lowest();
+    }
+    vec::Vec3F normalsSum{};
+    for (auto t = chunk.firstTriangle; t < chunk.lastTriangle; t++) {
+        for (std::size_t index : _triangles[t]) {
+            chunk.firstVertex = std::min(chunk.firstVertex, index);
+            chunk.lastVertex = std::max(chunk.lastVertex, index + 1);
+            auto vertex = this->vertex(index);
+            for (std::size_t i = 0; i < 3; i++) {
+                chunk.box[i * 2] = std::min(chunk.box[i * 2], vertex[i]);
+                chunk.box[i * 2 + 1] =
+                    std::max(chunk.box[i * 2 + 1], vertex[i]);
+            }
+        }
+        auto normal = triangleNormal(_triangles[t]);
+        if (normal.length() > 0)
+            normalsSum += vec::normalize(normal);
+    }
+
+    chunk.center = {(chunk.box[0] + chunk.box[1]) / 2,
+                    (chunk.box[2] + chunk.box[3]) / 2,
+                    (chunk.box[4] + chunk.box[5]) / 2};
+    chunk.radius = 0;
+    for (auto t = chunk.firstTriangle; t < chunk.lastTriangle; t++)
+        for (auto index : _triangles[t])
+            chunk.radius = std::max(
+                chunk.radius,
+                (vertex(index).trim<3>() - chunk.center).length());
+
+    // cone which doesn't fit into half-space can't cull anything
+    chunk.coneCos = -1;
+    chunk.coneSin = 0;
+    if (!(normalsSum.length() > 0))
+        return;
+    chunk.coneAxis = vec::normalize(normalsSum);
+    floating coneCos = 1;
+    for (auto t = chunk.firstTriangle; t < chunk.lastTriangle; t++) {
+        auto normal = triangleNormal(_triangles[t]);
+        if (normal.length() > 0)
+            coneCos =
+                std::min(coneCos, vec::normalize(normal) * chunk.coneAxis);
+    }
+    if (coneCos > 0) {
+        chunk.coneCos = coneCos;
+        chunk.coneSin = std::sqrt(1 - coneCos * coneCos);
+    }
+}
+
+vec::Vec3F Model::triangleNormal(const Triangle &triangle) const noexcept
+{
+    auto a = vertex(triangle[0]).trim<3>();
+    return vec::cross(vertex(triangle[2]).trim<3>() - a,
+                      vertex(triangle[1]).trim<3>() - a);
+}
+
 void Model::addModelTransformation(mtr::Matrix transformation) noexcept
 {
     modelMatrix = transformation * modelMatrix;
+    matrixChanged();
 }
 
 [[nodiscard]] mtr::Matrix Model::getModelMatrix() const noexcept
@@ -25,31 +237,96 @@ void Model::addModelTransformation(mtr::Matrix transformation) noexcept
 void Model::rotateX(floating degree) noexcept
 {
     modelMatrix = mtr::Matrix::getRotateX(degree) * modelMatrix;
+    matrixChanged();
 }
 
 void Model::rotateY(floating degree) noexcept
 {
     modelMatrix = mtr::Matrix::getRotateY(degree) * modelMatrix;
+    matrixChanged();
 }
 
 void Model::rotateZ(floating degree) noexcept
 {
     modelMatrix = mtr::Matrix::getRotateZ(degree) * modelMatrix;
+    matrixChanged();
 }
 
 void Model::scale(floating on) noexcept
 {
     modelMatrix = mtr::Matrix::getScale({on, on, on}) * modelMatrix;
+    matrixChanged();
 }
 
 void Model::move(vec::Vec3F where) noexcept
 {
     modelMatrix = mtr::Matrix::getMove(where) * modelMatrix;
+    matrixChanged();
 }
 
 void Model::clearModelMatrix() noexcept
 {
     modelMatrix = mtr::Matrix::createIdentityMatrix();
+    matrixChanged();
+}
+
+void Model::matrixChanged() noexcept
+{
+    _matrixVersion++;
+    _version++;
+}
+
+const std::vector<Vertex> &Model::getWorldVertices()
+{
+    updateWorldSpace();
+    return _worldVertices;
+}
+
+const std::vector<Normal> &Model::getWorldNormals()
+{
+    updateWorldSpace();
+    return _worldNormals;
+}
+
+const NormalMatrix &Model::getNormalMatrix()
+{
+    updateWorldSpace();
+    return _normalMatrix;
+}
+
+void Model::updateWorldSpace()
+{
+    if (_worldVersion != _matrixVersion) {
+        _worldVertices.clear();
+        _worldNormals.clear();
+        // columns of inverse transposed matrix are cross products of columns
+        // of matrix divided by determinant
+        auto column = [this](vec::Vec4F axis) {
+            return (modelMatrix * axis).trim<3>();
+        };
+        std::array columns{column({1, 0, 0, 0}), column({0, 1, 0, 0}),
+                           column({0, 0, 1, 0})};
+        auto determinant = vec::cross(columns[0], columns[1]) * columns[2];
+        if (determinant != 0)
+            columns = {vec::cross(columns[1], columns[2]) / determinant,
+                       vec::cross(columns[2], columns[0]) / determinant,
+                       vec::cross(columns[0], columns[1]) / determinant};
+        for (std::size_t row = 0; row < 3; row++)
+            _normalMatrix[row] = {columns[0][row], columns[1][row],
+                                  columns[2][row]};
+        _worldVersion = _matrixVersion;
+    }
+    // geometry which was appended since previous call is at the end
+    auto firstVertex = _worldVertices.size();
+    _worldVertices.resize(verticesCount());
+    for (auto i = firstVertex; i < _worldVertices.size(); i++)
+        _worldVertices[i] = modelMatrix * vertex(i);
+    auto firstNormal = _worldNormals.size();
+    _worldNormals.resize(_normals.size());
+    for (auto i = firstNormal; i < _worldNormals.size(); i++)
+        _worldNormals[i] = {_normalMatrix[0] * _normals[i],
+                            _normalMatrix[1] * _normals[i],
+                            _normalMatrix[2] * _normals[i]};
 }
 
 [[nodiscard]] vec::Vec3F Model::getAlbedo() const noexcept { return _albedo; }
@@ -65,15 +342,27 @@ void Model::setShinePower(floating newShinePower) noexcept
 
 void Model::setDiffuseMap(std::unique_ptr<Fl_RGB_Image> &&diffuse)
 {
-    _diffuseMap = std::move(diffuse);
+    _diffuseMap = toTexture(diffuse);
 }
 void Model::setSpecularMap(std::unique_ptr<Fl_RGB_Image> &&specular)
 {
-    _specularMap = std::move(specular);
+    _specularMap = toTexture(specular);
 }
 void Model::setNormalMap(std::unique_ptr<Fl_RGB_Image> &&normal)
 {
-    _normalMap = std::move(normal);
+    _normalMap = toTexture(normal, TextureContent::Normal);
+}
+
+std::unique_ptr<Texture>
+Model::toTexture(const std::unique_ptr<Fl_RGB_Image> &image,
+                 TextureContent content)
+{
+    if (!image)
+        return nullptr;
+    return std::make_unique<Texture>(
+        image->data()[0], static_cast<uint32_t>(image->w()),
+        static_cast<uint32_t>(image->h()), static_cast<uint8_t>(image->d()),
+        content);
 }
 
 } // namespace eng::ent
\ No newline at end of file
@@ -3,7 +3,10 @@
 #include "../../base/src/Elements.h"
 #include "../../matrix/src/Matrix.h"
 #include "../../vector/src/DimensionalVector.h"
+#include "Texture.h"
 #include <FL/Fl_RGB_Image.H>
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -15,18 +18,46 @@ namespace eng::ent {
  * rasterization polygons have refs to vertex must be way work with triangles
  * only (then when reading polygon will be divided) and with original polygons
  * (needs reconfigure) color mode is also optional as texture mode
+ *
+ * Vertices are welded: triangle is three indexes which are the same for
+ * every attribute, normals and texture coordinates are either empty or of
+ * the same size as vertices.
  */
 
 class Model final {
 public:
     static constexpr vec::Vec3F defaultAlbedo = {0.18f, 0.18f, 0.18f};
     static constexpr unsigned defaultShinePower = 32;
+    static constexpr std::size_t chunkSize = 128;
+
+    // box in format of alg::boundingBox<3>, in model space
+    using BoundingBox = std::array<floating, 6>;
+
+    /*
+     * Chunk is up to chunkSize consecutive triangles, which are connected
+     * patch of surface, and range of vertices they refer to. Ranges are
+     * half-open. Bounding box and sphere hold vertices of chunk. Normal of
+     * every triangle, cross(c - a, b - a), is at angle with cos >= coneCos to
+     * coneAxis, coneCos is -1 for chunk which normals don't fit in half-space.
+     */
+    struct Chunk {
+        std::size_t firstTriangle, lastTriangle;
+        std::size_t firstVertex, lastVertex;
+        BoundingBox box;
+        vec::Vec3F center;
+        floating radius;
+        vec::Vec3F coneAxis;
+        floating coneCos, coneSin;
+    };
 
     Model()
-        : _vertices{}, _normals{}, _textureCoords{}, _triangles{},
-          _diffuseMap(), _normalMap(), _specularMap(), _albedo{defaultAlbedo},
+        : _positions{}, _normals{}, _textureCoords{}, _triangles{},
+          _boundingBox{}, _chunks{}, _diffuseMap(),
+          _normalMap(),
+          _specularMap(), _albedo{defaultAlbedo},
           modelMatrix{mtr::Matrix::createIdentityMatrix()},
-          _shinePower{defaultShinePower}
+          _shinePower{defaultShinePower}, _version{1}, _matrixVersion{1},
+          _worldVersion{0}, _worldVertices{}, _worldNormals{}, _normalMatrix{}
     {}
     Model(std::vector<Vertex> &&vertices, std::vector<Triangle> &&polygons,
           std::vector<Normal> &&normals = {},
@@ -36,17 +67,36 @@ public:
           std::unique_ptr<Fl_RGB_Image> &&diffuseMap = nullptr,
           std::unique_ptr<Fl_RGB_Image> &&normalMap = nullptr,
           std::unique_ptr<Fl_RGB_Image> &&specularMap = nullptr)
-        : _vertices(std::move(vertices)), _normals(std::move(normals)),
-          _textureCoords(std::move(textureCoords)), _triangles(polygons),
-          _diffuseMap{std::move(diffuseMap)}, _normalMap{std::move(normalMap)},
-          _specularMap{std::move(specularMap)}, _albedo{albedo},
+        : _positions{}, _normals(std::move(normals)),
+          _textureCoords(std::move(textureCoords)),
+          _triangles(std::move(polygons)), _boundingBox{}, _chunks{},
+          _diffuseMap{toTexture(diffuseMap)},
+          _normalMap{toTexture(normalMap, TextureContent::Normal)},
+          _specularMap{toTexture(specularMap)}, _albedo{albedo},
           modelMatrix{mtr::Matrix::createIdentityMatrix()},
-          _shinePower{shinePower}
-    {}
+          _shinePower{shinePower}, _version{1}, _matrixVersion{1},
+          _worldVersion{0}, _worldVertices{}, _worldNormals{}, _normalMatrix{}
+    {
+        appendPositions(vertices);
+        buildChunks(0, 0);
+    }
 
     void reset(std::vector<Vertex> &&vertices, std::vector<Triangle> &&polygons,
                std::vector<Normal> &&normals,
                std::vector<TextureCoord> &&textureCoords);
+    // geometry which was set before, triangles are already ordered by chunks,
+    // so chunks aren't built again
+    void reset(VertexStreams &&positions, std::vector<Triangle> &&polygons,
+               std::vector<Normal> &&normals,
+               std::vector<TextureCoord> &&textureCoords,
+               std::vector<Chunk> &&chunks);
+    // geometry is added after the one which is already set, triangles are
+    // indexes in whole model, chunks are built only for added triangles;
+    // attribute which only one of geometries has is zero for the other one
+    void append(std::vector<Vertex> &&vertices,
+                std::vector<Triangle> &&polygons,
+                std::vector<Normal> &&normals,
+                std::vector<TextureCoord> &&textureCoords);
 
     void addModelTransformation(mtr::Matrix transformation) noexcept;
 
@@ -64,12 +114,27 @@ public:
 
     void clearModelMatrix() noexcept;
 
+    // changes with every change of geometry or model matrix
+    [[nodiscard]] uint64_t getVersion() const noexcept { return _version; }
+
+    /*
+     * Vertices multiplied by model matrix and normals multiplied by normal
+     * matrix, which is model one if it's singular. They are recomputed on
+     * first call after model changes, so camera movement reuses them.
+     * References are valid until next change.
+     */
+    [[nodiscard]] const std::vector<Vertex> &getWorldVertices();
+    [[nodiscard]] const std::vector<Normal> &getWorldNormals();
+    [[nodiscard]] const NormalMatrix &getNormalMatrix();
+
     [[nodiscard]] vec::Vec3F getAlbedo() const noexcept;
     void setAlbedo(vec::Vec3F newAlbedo) noexcept;
 
     [[nodiscard]] floating getShinePower() const noexcept;
     void setShinePower(floating newShinePower) noexcept;
 
+    // maps are converted to textures with mip levels, image isn't kept,
+    // normal map is decoded to normals
     void setDiffuseMap(std::unique_ptr<Fl_RGB_Image> &&diffuse);
     void setSpecularMap(std::unique_ptr<Fl_RGB_Image> &&specular);
     void setNormalMap(std::unique_ptr<Fl_RGB_Image> &&normal);
@@ -77,24 +142,40 @@ public:
     const auto &getNormalMap() const noexcept { return _normalMap; }
     const auto &getSpecularMap() const noexcept { return _specularMap; }
 
-    [[nodiscard]] inline auto trianglesBegin() const noexcept
+    // positions of vertices are kept only as streams of coordinates, which
+    // batched transform reads
+    [[nodiscard]] const VertexStreams &getPositions() const noexcept
     {
-        return _triangles.cbegin();
+        return _positions;
+    }
+    [[nodiscard]] std::size_t verticesCount() const noexcept
+    {
+        return _positions.x.size();
+    }
+    [[nodiscard]] Vertex vertex(std::size_t index) const noexcept
+    {
+        return {_positions.x[index], _positions.y[index],
+                _positions.z[index], _positions.w[index]};
     }
 
-    [[nodiscard]] inline auto trianglesEnd() const noexcept
+    // triangles are reordered by chunks when geometry is set
+    [[nodiscard]] const BoundingBox &getBoundingBox() const noexcept
     {
-        return _triangles.cend();
+        return _boundingBox;
+    }
+    [[nodiscard]] const std::vector<Chunk> &getChunks() const noexcept
+    {
+        return _chunks;
     }
 
-    [[nodiscard]] inline auto verticesBegin() const noexcept
+    [[nodiscard]] inline auto trianglesBegin() const noexcept
     {
-        return _vertices.cbegin();
+        return _triangles.cbegin();
     }
 
-    [[nodiscard]] inline auto verticesEnd() const noexcept
+    [[nodiscard]] inline auto trianglesEnd() const noexcept
     {
-        return _vertices.cend();
+        return _triangles.cend();
     }
 
     [[nodiscard]] inline auto normalsBegin() const noexcept
@@ -117,16 +198,40 @@ public:
     }
 
 private:
-    std::vector<Vertex> _vertices;
+    void appendPositions(const std::vector<Vertex> &vertices);
+    void matrixChanged() noexcept;
+    // vertices and normals which are in world space already are transformed
+    // again only after matrix changes
+    void updateWorldSpace();
+    // elements from firstVertex and firstTriangle are the new ones
+    void buildChunks(std::size_t firstVertex, std::size_t firstTriangle);
+    void computeChunkBounds(Chunk &chunk) const noexcept;
+    [[nodiscard]] vec::Vec3F
+    triangleNormal(const Triangle &triangle) const noexcept;
+
+    VertexStreams _positions;
     std::vector<Normal> _normals;
     std::vector<TextureCoord> _textureCoords;
     std::vector<Triangle> _triangles;
-    std::unique_ptr<Fl_RGB_Image> _diffuseMap;
-    std::unique_ptr<Fl_RGB_Image> _normalMap;
-    std::unique_ptr<Fl_RGB_Image> _specularMap;
+    BoundingBox _boundingBox;
+    std::vector<Chunk> _chunks;
+    [[nodiscard]] static std::unique_ptr<Texture>
+    toTexture(const std::unique_ptr<Fl_RGB_Image> &image,
+              TextureContent content = TextureContent::Color);
+
+    std::unique_ptr<Texture> _diffuseMap;
+    std::unique_ptr<Texture> _normalMap;
+    std::unique_ptr<Texture> _specularMap;
     vec::Vec3F _albedo;
     mtr::Matrix modelMatrix;
     floating _shinePower;
+    uint64_t _version;
+    // changes with model matrix, world space is computed for _worldVersion
+    uint64_t _matrixVersion;
+    uint64_t _worldVersion;
+    std::vector<Vertex> _worldVertices;
+    std::vector<Normal> _worldNormals;
+    NormalMatrix _normalMatrix;
 };
 
 } // namespace eng::ent
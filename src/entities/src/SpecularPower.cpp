@@ -0,0 +1,31 @@
+#include "SpecularPower.h"
+
+namespace eng::ent {
+
+void SpecularPower::setMode(SpecularMode newMode)
+{
+    _mode = newMode;
+    if (_mode == SpecularMode::Table && !std::isnan(_shine))
+        rebuildTable();
+}
+
+void SpecularPower::prepare(floating shine)
+{
+    if (shine == _shine)
+        return;
+    _shine = shine;
+    if (_mode == SpecularMode::Table)
+        rebuildTable();
+}
+
+void SpecularPower::rebuildTable()
+{
+    _table.resize(tableSize + 2);
+    for (std::size_t i = 0; i <= tableSize; i++)
+        _table[i] = std::pow(static_cast<floating>(i) /
+                                 static_cast<floating>(tableSize),
+                             _shine);
+    _table[tableSize + 1] = _table[tableSize];
+}
+
+} // namespace eng::ent
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../../base/src/Elements.h"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace eng::ent {
+
+// Exact is std::pow, Table interpolates values precomputed for prepared
+// shine, Schlick is rational approximation x / (n - n * x + x)
+enum class SpecularMode { Exact, Table, Schlick };
+
+/*
+ * Raises cosine between reflected and view vectors to shine power. Fast
+ * modes are used only for shine the object is prepared for, any other shine
+ * is raised by std::pow. They clamp cosine to [0, 1], so cosine which is
+ * less than zero or NaN gives zero.
+ */
+class SpecularPower {
+public:
+    // intervals of table on [0, 1]
+    static constexpr std::size_t tableSize = 4096;
+
+    [[nodiscard]] SpecularMode getMode() const noexcept { return _mode; }
+    void setMode(SpecularMode newMode);
+
+    // table is rebuilt only if shine differs from prepared one
+    void prepare(floating shine);
+
+    [[nodiscard]] bool isApproximated(floating shine) const noexcept
+    {
+        return _mode != SpecularMode::Exact && shine == _shine;
+    }
+
+    // tableSize + 2 values, the last one repeats value for 1
+    [[nodiscard]] const floating *table() const noexcept
+    {
+        return _table.data();
+    }
+
+    [[nodiscard]] floating operator()(floating cosine,
+                                      floating shine) const noexcept
+    {
+        if (!isApproximated(shine))
+            return std::pow(cosine, shine);
+        cosine = clampCosine(cosine);
+        if (_mode == SpecularMode::Schlick)
+            return cosine / (shine - shine * cosine + cosine);
+        auto position = cosine * static_cast<floating>(tableSize);
+        auto index = static_cast<int>(position);
+        auto fraction = position - static_cast<floating>(index);
+        auto low = _table[static_cast<std::size_t>(index)];
+        auto high = _table[static_cast<std::size_t>(index) + 1];
+        return low + (high - low) * fraction;
+    }
+
+    static floating clampCosine(floating cosine) noexcept
+    {
+        cosine = cosine > 0 ? cosine : 0;
+        return cosine < 1 ? cosine : 1;
+    }
+
+private:
+    void rebuildTable();
+
+    SpecularMode _mode{SpecularMode::Exact};
+    floating _shine{NAN};
+    std::vector<floating> _table;
+};
+
+} // namespace eng::ent
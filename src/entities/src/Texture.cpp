@@ -0,0 +1,225 @@
+#include "Texture.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace eng::ent {
+
+namespace {
+
+constexpr floating snormScale = 127;
+
+} // namespace
+
+Texture::Texture(const char *data, uint32_t width, uint32_t height,
+                 uint8_t channel, TextureContent content)
+    : _content{content},
+      _levels{makeLevel(std::max(width, 1u), std::max(height, 1u), 0)},
+      _texels{}
+{
+    const auto &first = _levels[0];
+    _texels.resize(std::size_t{first.tilesInRow} * first.tilesInColumn *
+                   tileSide * tileSide);
+    if (data && width != 0 && height != 0 && channel != 0) {
+        for (uint32_t y = 0; y < height; y++)
+            for (uint32_t x = 0; x < width; x++) {
+                auto from = reinterpret_cast<const uint8_t *>(data) +
+                            (std::size_t{y} * width + x) * channel;
+                vec::Vec3F value{};
+                for (std::size_t k = 0; k < 3; k++)
+                    value[k] =
+                        static_cast<floating>(from[channel >= 3 ? k : 0]);
+                if (_content == TextureContent::Normal)
+                    value = value / 0xFF * 2 - vec::Vec3F{1, 1, 1};
+                _texels[first.index(x, y)] = encode(value);
+            }
+    }
+    buildLevels();
+}
+
+Texture::Level Texture::makeLevel(uint32_t width, uint32_t height,
+                                  std::size_t offset) noexcept
+{
+    return {width, height, offset, (width + tileSide - 1) / tileSide,
+            (height + tileSide - 1) / tileSide};
+}
+
+void Texture::buildLevels()
+{
+    while (_levels.back().width > 1 || _levels.back().height > 1) {
+        auto previous = _levels.back();
+        auto level = makeLevel(std::max(previous.width / 2, 1u),
+                               std::max(previous.height / 2, 1u),
+                               _texels.size());
+        _texels.resize(level.offset + std::size_t{level.tilesInRow} *
+                                          level.tilesInColumn * tileSide *
+                                          tileSide);
+        auto texelOf = [&](uint32_t x, uint32_t y) {
+            return _texels[previous.index(std::min(x, previous.width - 1),
+                                          std::min(y, previous.height - 1))];
+        };
+        auto from = [&](uint32_t x, uint32_t y, uint32_t k) {
+            return (texelOf(x, y) >> (k * 8)) & 0xFF;
+        };
+        for (uint32_t y = 0; y < level.height; y++)
+            for (uint32_t x = 0; x < level.width; x++) {
+                if (_content == TextureContent::Normal) {
+                    // encoding normalizes sum
+                    _texels[level.index(x, y)] = encode(
+                        decode(texelOf(2 * x, 2 * y)) +
+                        decode(texelOf(2 * x + 1, 2 * y)) +
+                        decode(texelOf(2 * x, 2 * y + 1)) +
+                        decode(texelOf(2 * x + 1, 2 * y + 1)));
+                    continue;
+                }
+                uint32_t rgba = 0;
+                for (uint32_t k = 0; k < 3; k++)
+                    rgba |= ((from(2 * x, 2 * y, k) +
+                              from(2 * x + 1, 2 * y, k) +
+                              from(2 * x, 2 * y + 1, k) +
+                              from(2 * x + 1, 2 * y + 1, k) + 2) /
+                             4)
+                            << (k * 8);
+                _texels[level.index(x, y)] = rgba;
+            }
+        _levels.push_back(level);
+    }
+}
+
+uint32_t Texture::fetch(const Level &current, int64_t x,
+                        int64_t y) const noexcept
+{
+    auto column = static_cast<uint32_t>(
+        std::clamp<int64_t>(x, 0, int64_t{current.width} - 1));
+    auto row = static_cast<uint32_t>(
+        std::clamp<int64_t>(y, 0, int64_t{current.height} - 1));
+    return _texels[current.index(column, row)];
+}
+
+uint32_t Texture::encode(vec::Vec3F value) const noexcept
+{
+    if (_content == TextureContent::Color) {
+        uint32_t rgba = 0;
+        for (std::size_t k = 0; k < 3; k++)
+            rgba |= static_cast<uint32_t>(std::lround(std::clamp<floating>(
+                        value[k], 0, 0xFF)))
+                    << (k * 8);
+        return rgba;
+    }
+    // zero vector goes to z axis
+    auto length = value.length();
+    if (!(length > 0))
+        return uint32_t{static_cast<uint8_t>(snormScale)} << 16;
+    uint32_t xyz = 0;
+    for (std::size_t k = 0; k < 3; k++) {
+        auto scaled = std::lround(
+            std::clamp<floating>(value[k] / length, -1, 1) * snormScale);
+        xyz |= uint32_t{static_cast<uint8_t>(scaled)} << (k * 8);
+    }
+    return xyz;
+}
+
+template <TextureContent Content>
+vec::Vec3F Texture::decodeAs(uint32_t texel) noexcept
+{
+    if constexpr (Content == TextureContent::Color)
+        return {static_cast<floating>(texel & 0xFF),
+                static_cast<floating>((texel >> 8) & 0xFF),
+                static_cast<floating>((texel >> 16) & 0xFF)};
+    return {static_cast<floating>(static_cast<int8_t>(texel & 0xFF)) *
+                (1 / snormScale),
+            static_cast<floating>(static_cast<int8_t>((texel >> 8) & 0xFF)) *
+                (1 / snormScale),
+            static_cast<floating>(static_cast<int8_t>((texel >> 16) & 0xFF)) *
+                (1 / snormScale)};
+}
+
+vec::Vec3F Texture::decode(uint32_t texel) const noexcept
+{
+    return _content == TextureContent::Color
+               ? decodeAs<TextureContent::Color>(texel)
+               : decodeAs<TextureContent::Normal>(texel);
+}
+
+vec::Vec3F Texture::texel(std::size_t level, int64_t x,
+                          int64_t y) const noexcept
+{
+    return decode(fetch(_levels[level], x, y));
+}
+
+template <TextureContent Content>
+vec::Vec3F Texture::bilinear(std::size_t level, floating x,
+                             floating y) const noexcept
+{
+    const auto &current = _levels[level];
+    // centers of texels of level are moved to level 0 ones
+    auto levelX = (x + 0.5f) * static_cast<floating>(current.width) /
+                      static_cast<floating>(_levels[0].width) -
+                  0.5f;
+    auto levelY = (y + 0.5f) * static_cast<floating>(current.height) /
+                      static_cast<floating>(_levels[0].height) -
+                  0.5f;
+    auto left = std::floor(levelX), top = std::floor(levelY);
+    auto fractionX = levelX - left, fractionY = levelY - top;
+    auto column = static_cast<int64_t>(left), row = static_cast<int64_t>(top);
+    // four texels are in one tile unless they are on its or texture edges
+    std::array<uint32_t, 4> quad{};
+    if (column >= 0 && row >= 0 && column + 1 < int64_t{current.width} &&
+        row + 1 < int64_t{current.height} &&
+        column % tileSide != tileSide - 1 && row % tileSide != tileSide - 1) {
+        auto first =
+            _texels.data() + current.index(static_cast<uint32_t>(column),
+                                           static_cast<uint32_t>(row));
+        quad = {first[0], first[1], first[tileSide], first[tileSide + 1]};
+    } else {
+        quad = {fetch(current, column, row), fetch(current, column + 1, row),
+                fetch(current, column, row + 1),
+                fetch(current, column + 1, row + 1)};
+    }
+    auto upper = decodeAs<Content>(quad[0]) * (1 - fractionX) +
+                 decodeAs<Content>(quad[1]) * fractionX;
+    auto lower = decodeAs<Content>(quad[2]) * (1 - fractionX) +
+                 decodeAs<Content>(quad[3]) * fractionX;
+    return upper * (1 - fractionY) + lower * fractionY;
+}
+
+template <TextureContent Content>
+vec::Vec3F Texture::filtered(floating x, floating y, floating lod,
+                             TextureFilter filter) const noexcept
+{
+    switch (filter) {
+    case TextureFilter::Nearest:
+        return decodeAs<Content>(fetch(_levels[0],
+                                       static_cast<int64_t>(std::floor(x)),
+                                       static_cast<int64_t>(std::floor(y))));
+    case TextureFilter::Bilinear:
+        return bilinear<Content>(static_cast<std::size_t>(std::lround(lod)), x,
+                                 y);
+    case TextureFilter::Trilinear:
+        break;
+    }
+    auto level = static_cast<std::size_t>(lod);
+    auto fraction = lod - static_cast<floating>(level);
+    if (level + 1 >= _levels.size())
+        return bilinear<Content>(level, x, y);
+    return bilinear<Content>(level, x, y) * (1 - fraction) +
+           bilinear<Content>(level + 1, x, y) * fraction;
+}
+
+vec::Vec3F Texture::sample(floating x, floating y, floating lod,
+                           TextureFilter filter) const noexcept
+{
+    // coordinates far out of texture are clamped before conversion to
+    // integers, NaN goes to the first texel
+    auto limit = static_cast<floating>(std::max(width(), height())) + 2;
+    x = std::clamp(std::isnan(x) ? 0 : x, -limit, limit);
+    y = std::clamp(std::isnan(y) ? 0 : y, -limit, limit);
+    auto maxLod = static_cast<floating>(_levels.size() - 1);
+    lod = lod > 0 ? lod : 0;
+    lod = lod < maxLod ? lod : maxLod;
+    return _content == TextureContent::Color
+               ? filtered<TextureContent::Color>(x, y, lod, filter)
+               : filtered<TextureContent::Normal>(x, y, lod, filter);
+}
+
+} // namespace eng::ent
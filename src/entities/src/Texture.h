@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../../base/src/AlignedAllocator.h"
+#include "../../base/src/Elements.h"
+#include "../../vector/src/DimensionalVector.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eng::ent {
+
+// Nearest takes texel of full resolution level, Bilinear filters level of
+// detail rounded to the nearest one, Trilinear blends two nearest levels
+enum class TextureFilter { Nearest, Bilinear, Trilinear };
+
+// Color texel is RGB in [0, 255], Normal one is direction decoded from RGB
+// of normal map, where channel c is c / 255 * 2 - 1
+enum class TextureContent { Color, Normal };
+
+/*
+ * RGB texture with chain of mip levels. Every level is half of previous one
+ * rounded down, but not less than one texel, its texel is average of up to
+ * four texels of previous level. Coordinates are in texels of level 0 with
+ * texel centers at integers, level of detail is log2 of texels per pixel.
+ * Coordinates out of texture are clamped to its edges.
+ *
+ * Texel is four bytes. Color is RGBA, alpha is padding. Normal is
+ * normalized once when texture is built, its coordinates are 8 bit signed
+ * normalized numbers, so it's decoded as cheap as color. Mip level of
+ * normals averages directions, not bytes. Level is stored by tiles of
+ * tileSide x tileSide texels, a tile is one cache line, so neighbours of
+ * texel are close in memory along any direction, not only along row.
+ */
+class Texture final {
+public:
+    static constexpr uint32_t tileSide = 4;
+
+    // data is row by row texels of channel bytes, the first three are RGB,
+    // texture with one or two channels is gray
+    Texture(const char *data, uint32_t width, uint32_t height,
+            uint8_t channel, TextureContent content = TextureContent::Color);
+
+    [[nodiscard]] uint32_t width() const noexcept { return _levels[0].width; }
+    [[nodiscard]] uint32_t height() const noexcept
+    {
+        return _levels[0].height;
+    }
+    [[nodiscard]] std::size_t levelsCount() const noexcept
+    {
+        return _levels.size();
+    }
+
+    // color with channels in [0, 255] or normal, which isn't normalized
+    // after filtering
+    [[nodiscard]] vec::Vec3F sample(floating x, floating y, floating lod,
+                                    TextureFilter filter) const noexcept;
+
+    // texel of level, coordinates are clamped to level
+    [[nodiscard]] vec::Vec3F texel(std::size_t level, int64_t x,
+                                   int64_t y) const noexcept;
+
+private:
+    struct Level {
+        uint32_t width, height;
+        // of the first texel in _texels
+        std::size_t offset;
+        // width and height are rounded up to whole tiles
+        uint32_t tilesInRow, tilesInColumn;
+
+        [[nodiscard]] std::size_t index(uint32_t x, uint32_t y) const noexcept
+        {
+            auto tile = std::size_t{y / tileSide} * tilesInRow + x / tileSide;
+            return offset + tile * tileSide * tileSide +
+                   (y % tileSide) * tileSide + x % tileSide;
+        }
+    };
+
+    [[nodiscard]] static Level makeLevel(uint32_t width, uint32_t height,
+                                         std::size_t offset) noexcept;
+    void buildLevels();
+    // packed texel, coordinates are clamped to level
+    [[nodiscard]] uint32_t fetch(const Level &current, int64_t x,
+                                 int64_t y) const noexcept;
+    [[nodiscard]] uint32_t encode(vec::Vec3F value) const noexcept;
+    [[nodiscard]] vec::Vec3F decode(uint32_t texel) const noexcept;
+    // filters are instantiated for content, so decoding doesn't branch
+    template <TextureContent Content>
+    [[nodiscard]] static vec::Vec3F decodeAs(uint32_t texel) noexcept;
+    template <TextureContent Content>
+    [[nodiscard]] vec::Vec3F bilinear(std::size_t level, floating x,
+                                      floating y) const noexcept;
+    template <TextureContent Content>
+    [[nodiscard]] vec::Vec3F filtered(floating x, floating y, floating lod,
+                                      TextureFilter filter) const noexcept;
+
+    TextureContent _content;
+    std::vector<Level> _levels;
+    static_assert(tileSide * tileSide * sizeof(uint32_t) == cacheLineSize,
+                  "tile is one cache line");
+    // texels of all levels, red or the first coordinate is the lowest,
+    // levels start at whole tiles, so every tile is in its own cache line
+    std::vector<uint32_t, AlignedAllocator<uint32_t, cacheLineSize>> _texels;
+};
+
+} // namespace eng::ent
@@ -0,0 +1,482 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "../src/Camera.h"
+#include "../src/Light.h"
+#include "../src/MeshCache.h"
+#include "../src/Model.h"
+#include "../src/Texture.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+using namespace eng;
+
+TEST_CASE("Light array sums the same intensities as lights one by one")
+{
+    using Intensities = ent::LightArray::Intensities;
+    // lights evaluated one by one as single light objects were
+    auto modulate = [](vec::Vec3F color, floating factor, vec::Vec3F by) {
+        return vec::Vec3F{color[0] * factor * by[0], color[1] * factor * by[1],
+                          color[2] * factor * by[2]};
+    };
+    auto lit = [&](vec::Vec3F color, vec::Vec3F direction, vec::Vec3F normal,
+                   vec::Vec3F albedo, vec::Vec3F specular, vec::Vec3F view,
+                   floating shine, Intensities &result) {
+        auto normalLightDot = normal * direction;
+        if (normalLightDot > 0) {
+            auto reflect =
+                (direction - normal * (2 * normalLightDot)).normalize();
+            result.diffuse = modulate(color, normalLightDot, albedo);
+            result.specular =
+                modulate(color, std::pow(reflect * view, shine), specular);
+        }
+    };
+    auto distant = [&](const ent::DistantLight &light, vec::Vec3F point,
+                       vec::Vec3F normal, vec::Vec3F albedo,
+                       vec::Vec3F specular, vec::Vec3F camera,
+                       floating shine) {
+        Intensities result{
+            modulate(light.color, light.ambientIntensity, albedo), {}, {}};
+        lit(light.color, light.direction, normal, albedo, specular,
+            (camera - point).normalize(), shine, result);
+        return result;
+    };
+    auto pointLight = [&](const ent::PointLight &light, vec::Vec3F point,
+                          vec::Vec3F normal, vec::Vec3F albedo,
+                          vec::Vec3F specular, vec::Vec3F camera,
+                          floating shine) {
+        auto direction = light.position - point;
+        auto distance = direction.length();
+        auto attenuation = light.constantAttenuation +
+                           light.linearAttenuation * distance +
+                           light.expAttenuation * distance * distance;
+        Intensities result{
+            modulate(light.color, light.ambientIntensity, albedo), {}, {}};
+        lit(light.color, direction.normalize(), normal, albedo, specular,
+            (camera - point).normalize(), shine, result);
+        return Intensities{result.ambient / attenuation,
+                           result.diffuse / attenuation,
+                           result.specular / attenuation};
+    };
+
+    std::mt19937 mt(13);
+    std::uniform_real_distribution coordinate(-5.0f, 5.0f);
+    std::uniform_real_distribution unit(0.0f, 1.0f);
+    auto vector = [&](auto &distribution) {
+        return vec::Vec3F{distribution(mt), distribution(mt),
+                          distribution(mt)};
+    };
+    std::vector<ent::DistantLight> distantLights;
+    std::vector<ent::PointLight> pointLights;
+    ent::LightArray lights;
+    // types are interleaved, every type is summed in order it was added
+    for (unsigned i = 0; i < 4; i++) {
+        distantLights.emplace_back(vector(coordinate).normalize(),
+                                   vector(unit) * 255, unit(mt));
+        lights.push_back(distantLights.back());
+        pointLights.emplace_back(vector(coordinate), vector(unit) * 255,
+                                 unit(mt), 1 + unit(mt), unit(mt),
+                                 unit(mt) * 0.1f);
+        lights.push_back(pointLights.back());
+    }
+    REQUIRE(lights.size() == 8);
+
+    for (unsigned i = 0; i < 200; i++) {
+        auto point = vector(coordinate);
+        auto normal = vector(coordinate).normalize();
+        auto albedo = vector(unit), specular = vector(unit);
+        auto camera = vector(coordinate);
+        floating shine = i % 2 ? 8 : 32;
+        Intensities expected{};
+        auto add = [&expected](const Intensities &intensities) {
+            expected.ambient += intensities.ambient;
+            expected.diffuse += intensities.diffuse;
+            expected.specular += intensities.specular;
+        };
+        for (const auto &light : distantLights)
+            add(distant(light, point, normal, albedo, specular, camera,
+                        shine));
+        for (const auto &light : pointLights)
+            add(pointLight(light, point, normal, albedo, specular, camera,
+                           shine));
+        auto actual = lights.calculatePhongColor(point, normal, albedo,
+                                                 specular, camera, shine);
+        CHECK(actual.ambient == expected.ambient);
+        CHECK(actual.diffuse == expected.diffuse);
+        CHECK(actual.specular == expected.specular);
+    }
+}
+
+TEST_CASE("World vertices are recomputed only after model changes")
+{
+    ent::Model model;
+    model.reset({{1, 0, 0, 1}, {0, 2, 0, 1}, {0, 0, 3, 1}},
+                {Triangle{0, 1, 2}}, {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, {});
+    ent::Camera camera{{5, 0, 0}, {0, 0, 0}, {0, 1, 0}};
+
+    auto world = model.getWorldVertices();
+    CHECK((world[1] == Vertex{0, 2, 0, 1}));
+    auto version = model.getVersion();
+    const auto *data = model.getWorldVertices().data();
+
+    // camera doesn't belong to model, the same vertices are returned
+    camera.rotateX(30);
+    camera.moveAlongDiagonal(2);
+    CHECK(model.getVersion() == version);
+    CHECK(model.getWorldVertices().data() == data);
+    CHECK(model.getWorldVertices() == world);
+
+    model.move({1, 2, 3});
+    CHECK(model.getVersion() != version);
+    world = model.getWorldVertices();
+    CHECK((world[0] == Vertex{2, 2, 3, 1}));
+    CHECK((world[1] == Vertex{1, 4, 3, 1}));
+    CHECK((world[2] == Vertex{1, 2, 6, 1}));
+    // moving doesn't turn normals
+    CHECK((model.getWorldNormals()[2] == Normal{0, 0, 1}));
+
+    model.scale(2);
+    world = model.getWorldVertices();
+    CHECK((world[0] == Vertex{4, 4, 6, 1}));
+    CHECK((model.getWorldNormals()[0] == Normal{0.5f, 0, 0}));
+
+    // appended geometry is transformed by the same matrix
+    model.append({{1, 1, 1, 1}}, {Triangle{0, 1, 3}}, {}, {});
+    world = model.getWorldVertices();
+    REQUIRE(world.size() == 4);
+    CHECK((world[0] == Vertex{4, 4, 6, 1}));
+    CHECK((world[3] == Vertex{4, 6, 8, 1}));
+    CHECK(model.getWorldNormals().size() == 4);
+
+    // replaced geometry is transformed again, not appended
+    model.reset({{1, 0, 0, 1}, {0, 1, 0, 1}, {0, 0, 1, 1}},
+                {Triangle{0, 1, 2}}, {}, {});
+    world = model.getWorldVertices();
+    REQUIRE(world.size() == 3);
+    CHECK((world[0] == Vertex{4, 4, 6, 1}));
+    CHECK((world[1] == Vertex{2, 6, 6, 1}));
+    CHECK(model.getWorldNormals().empty());
+}
+
+TEST_CASE("Appended triangles are split on chunks of their own")
+{
+    // strip of quads, the second part refers to vertices of the first one
+    constexpr uint32_t columns = 200;
+    auto part = [](uint32_t first, uint32_t last) {
+        std::vector<Vertex> vertices;
+        for (auto column = first; column < last; column++)
+            for (uint32_t row = 0; row < 2; row++)
+                vertices.push_back({static_cast<floating>(column),
+                                    static_cast<floating>(row), 0, 1});
+        std::vector<Triangle> triangles;
+        for (auto column = std::max(first, 1u); column < last; column++) {
+            auto a = 2 * column - 2, b = 2 * column;
+            triangles.push_back({a, b, a + 1});
+            triangles.push_back({a + 1, b, b + 1});
+        }
+        return std::pair{vertices, triangles};
+    };
+    ent::Model model;
+    auto [vertices, triangles] = part(0, columns / 2);
+    model.reset(std::move(vertices), std::move(triangles), {}, {});
+    auto firstChunks = model.getChunks().size();
+    auto [moreVertices, moreTriangles] = part(columns / 2, columns);
+    model.append(std::move(moreVertices), std::move(moreTriangles), {}, {});
+
+    const auto &chunks = model.getChunks();
+    REQUIRE(chunks.size() > firstChunks);
+    CHECK(chunks[firstChunks].firstTriangle == (columns / 2 - 1) * 2);
+    CHECK(chunks.back().lastTriangle == (columns - 1) * 2);
+    bool contiguous = true, inRange = true;
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+        if (i > 0)
+            contiguous = contiguous &&
+                         chunks[i].firstTriangle == chunks[i - 1].lastTriangle;
+        for (auto t = chunks[i].firstTriangle; t < chunks[i].lastTriangle; t++)
+            for (std::size_t vertex : model.trianglesBegin()[
+                     static_cast<std::ptrdiff_t>(t)])
+                inRange = inRange && vertex >= chunks[i].firstVertex &&
+                          vertex < chunks[i].lastVertex;
+    }
+    CHECK(contiguous);
+    CHECK(inRange);
+    // triangle which joins parts refers to vertices of both
+    CHECK(chunks[firstChunks].firstVertex < columns);
+}
+
+TEST_CASE("Mip levels of texture are averages of previous ones")
+{
+    // levels are 5 x 3, 2 x 1 and 1 x 1
+    constexpr uint32_t width = 5, height = 3;
+    std::vector<char> data(width * height);
+    for (uint32_t i = 0; i < width * height; i++)
+        data[i] = static_cast<char>(i * 10);
+    ent::Texture texture{data.data(), width, height, 1};
+
+    REQUIRE(texture.levelsCount() == 3);
+    // gray texture has equal channels
+    CHECK((texture.texel(0, 1, 2) == vec::Vec3F{110, 110, 110}));
+    // (0 + 10 + 50 + 60 + 2) / 4
+    CHECK(texture.texel(1, 0, 0)[0] == 30);
+    // (20 + 30 + 70 + 80 + 2) / 4
+    CHECK(texture.texel(1, 1, 0)[0] == 50);
+    // the only row of level 1 is taken twice, (30 + 50 + 30 + 50 + 2) / 4
+    CHECK(texture.texel(2, 0, 0)[0] == 40);
+    // clamped to edge
+    CHECK(texture.texel(0, -3, 7)[0] == 100);
+
+    using ent::TextureFilter;
+    CHECK(texture.sample(1.7f, 0.2f, 0, TextureFilter::Nearest)[0] == 10);
+    // the middle between four texels is their average
+    CHECK(texture.sample(0.5f, 0.5f, 0, TextureFilter::Bilinear)[0] ==
+          doctest::Approx(30));
+    // level of detail is rounded by bilinear filter
+    CHECK(texture.sample(0.5f, 0.5f, 0.4f, TextureFilter::Bilinear)[0] ==
+          doctest::Approx(30));
+    CHECK(texture.sample(0.5f, 0.5f, 20, TextureFilter::Bilinear)[0] ==
+          doctest::Approx(40));
+    // trilinear blends neighbouring levels
+    auto first = texture.sample(0.5f, 0.5f, 1, TextureFilter::Bilinear);
+    auto second = texture.sample(0.5f, 0.5f, 2, TextureFilter::Bilinear);
+    CHECK(texture.sample(0.5f, 0.5f, 1.25f, TextureFilter::Trilinear)[0] ==
+          doctest::Approx(first[0] * 0.75f + second[0] * 0.25f));
+    // coordinates out of texture or NaN don't leave it
+    CHECK(texture.sample(NAN, 1e30f, 0, TextureFilter::Trilinear)[0] ==
+          doctest::Approx(100));
+}
+
+TEST_CASE("Bilinear filter takes the same texels inside and across tiles")
+{
+    constexpr uint32_t width = 11, height = 7;
+    std::vector<char> data(width * height * 3);
+    std::mt19937 mt(5);
+    for (auto &byte : data)
+        byte = static_cast<char>(mt());
+    ent::Texture texture{data.data(), width, height, 3};
+
+    std::uniform_real_distribution coordinate(-2.0f, 12.0f);
+    for (unsigned i = 0; i < 1000; i++) {
+        auto x = coordinate(mt), y = coordinate(mt);
+        auto left = std::floor(x), top = std::floor(y);
+        auto fractionX = x - left, fractionY = y - top;
+        auto column = static_cast<int64_t>(left);
+        auto row = static_cast<int64_t>(top);
+        auto upper = texture.texel(0, column, row) * (1 - fractionX) +
+                     texture.texel(0, column + 1, row) * fractionX;
+        auto lower = texture.texel(0, column, row + 1) * (1 - fractionX) +
+                     texture.texel(0, column + 1, row + 1) * fractionX;
+        auto expected = upper * (1 - fractionY) + lower * fractionY;
+        auto sampled = texture.sample(x, y, 0, ent::TextureFilter::Bilinear);
+        for (std::size_t k = 0; k < 3; k++)
+            CHECK(std::fabs(sampled[k] - expected[k]) < 1e-2f);
+    }
+}
+
+TEST_CASE("Normal map keeps directions of decoded normals")
+{
+    constexpr uint32_t size = 16;
+    std::vector<char> data(size * size * 3);
+    std::mt19937 mt(3);
+    for (auto &byte : data)
+        byte = static_cast<char>(mt());
+    ent::Texture texture{data.data(), size, size, 3,
+                         ent::TextureContent::Normal};
+
+    auto decoded = [&data](std::size_t texel) {
+        vec::Vec3F normal{};
+        for (std::size_t k = 0; k < 3; k++)
+            normal[k] = static_cast<floating>(
+                            static_cast<uint8_t>(data[texel * 3 + k])) /
+                            0xFF * 2 -
+                        1;
+        return normal.normalize();
+    };
+    for (uint32_t y = 0; y < size; y++)
+        for (uint32_t x = 0; x < size; x++) {
+            auto expected = decoded(y * size + x);
+            auto normal = texture.texel(0, x, y).normalize();
+            // 8 bit coordinates lose less than 1e-2 radian
+            CHECK(normal * expected > 0.99995f);
+        }
+
+    // level of two opposite normals along x and one along z is along z
+    std::vector<char> opposite{char(0xFF), char(0x80), char(0x80),
+                               0,          char(0x80), char(0x80),
+                               char(0x80), char(0x80), char(0xFF),
+                               char(0x80), char(0x80), char(0xFF)};
+    ent::Texture pair{opposite.data(), 2, 2, 3, ent::TextureContent::Normal};
+    auto averaged = pair.texel(1, 0, 0).normalize();
+    CHECK(averaged[2] > 0.9999f);
+}
+
+TEST_CASE("Normal matrix keeps normals perpendicular to surface")
+{
+    ent::Model model;
+    model.reset({{0, 0, 0, 1}, {1, 0, 0, 1}, {0, 1, 0, 1}},
+                {Triangle{0, 1, 2}}, {{1, 1, 1}, {1, 1, 1}, {1, 1, 1}}, {});
+    model.addModelTransformation(mtr::Matrix::getScale({1, 4, 0.5f}) *
+                                 mtr::Matrix::getRotateX(30));
+
+    // tangents of plane x + y + z = 0 go through model matrix
+    auto modelMatrix = model.getModelMatrix();
+    auto toWorld = [&modelMatrix](vec::Vec3F direction) {
+        return (modelMatrix *
+                vec::Vec4F{direction[0], direction[1], direction[2], 0})
+            .trim<3>();
+    };
+    auto first = toWorld({1, -1, 0}), second = toWorld({0, 1, -1});
+    auto normal = model.getWorldNormals()[0];
+    CHECK(normal * first == doctest::Approx(0).epsilon(1e-5));
+    CHECK(normal * second == doctest::Approx(0).epsilon(1e-5));
+    // it keeps side of surface
+    CHECK(normal * vec::cross(first, second) > 0);
+
+    const auto &matrix = model.getNormalMatrix();
+    vec::Vec3F byMatrix{matrix[0] * Normal{1, 1, 1},
+                        matrix[1] * Normal{1, 1, 1},
+                        matrix[2] * Normal{1, 1, 1}};
+    for (std::size_t k = 0; k < 3; k++)
+        CHECK(byMatrix[k] == doctest::Approx(normal[k]));
+}
+
+TEST_CASE("Mesh cache keeps model until its source changes")
+{
+    auto source = std::filesystem::temp_directory_path() / "enttest_mesh.obj";
+    auto sourcePath = source.string();
+    std::ofstream{source} << "v 0 0 0\n";
+    std::filesystem::remove(ent::meshCachePath(sourcePath));
+
+    // grid of several chunks
+    constexpr integral side = 20;
+    std::vector<Vertex> vertices;
+    std::vector<Normal> normals;
+    std::vector<TextureCoord> textureCoords;
+    std::vector<Triangle> triangles;
+    for (integral y = 0; y <= side; y++)
+        for (integral x = 0; x <= side; x++) {
+            vertices.push_back({static_cast<floating>(x),
+                                static_cast<floating>(y),
+                                static_cast<floating>((x * y) % 3), 1});
+            normals.push_back({0, 0, 1});
+            textureCoords.push_back({static_cast<floating>(x) / side,
+                                     static_cast<floating>(y) / side, 0});
+        }
+    auto corner = [](integral x, integral y) {
+        return static_cast<uint32_t>(y * (side + 1) + x);
+    };
+    for (integral y = 0; y < side; y++)
+        for (integral x = 0; x < side; x++) {
+            triangles.push_back(
+                {corner(x, y), corner(x + 1, y), corner(x, y + 1)});
+            triangles.push_back(
+                {corner(x + 1, y), corner(x + 1, y + 1), corner(x, y + 1)});
+        }
+    ent::Model model{std::move(vertices), std::move(triangles),
+                     std::move(normals), std::move(textureCoords)};
+    REQUIRE(model.getChunks().size() > 1);
+
+    ent::Model loaded;
+    CHECK_FALSE(ent::loadMeshCache(sourcePath, loaded));
+    ent::saveMeshCache(sourcePath, model);
+    REQUIRE(ent::loadMeshCache(sourcePath, loaded));
+
+    CHECK(model.getPositions().x == loaded.getPositions().x);
+    CHECK(model.getPositions().y == loaded.getPositions().y);
+    CHECK(model.getPositions().z == loaded.getPositions().z);
+    CHECK(model.getPositions().w == loaded.getPositions().w);
+    CHECK(std::equal(model.normalsBegin(), model.normalsEnd(),
+                     loaded.normalsBegin(), loaded.normalsEnd()));
+    CHECK(std::equal(model.textureCoordsBegin(), model.textureCoordsEnd(),
+                     loaded.textureCoordsBegin(), loaded.textureCoordsEnd()));
+    CHECK(std::equal(model.trianglesBegin(), model.trianglesEnd(),
+                     loaded.trianglesBegin(), loaded.trianglesEnd()));
+    CHECK(model.getBoundingBox() == loaded.getBoundingBox());
+    const auto &chunks = model.getChunks();
+    const auto &loadedChunks = loaded.getChunks();
+    REQUIRE(chunks.size() == loadedChunks.size());
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+        CHECK(chunks[i].firstTriangle == loadedChunks[i].firstTriangle);
+        CHECK(chunks[i].lastTriangle == loadedChunks[i].lastTriangle);
+        CHECK(chunks[i].box == loadedChunks[i].box);
+        CHECK(chunks[i].radius == loadedChunks[i].radius);
+        CHECK(chunks[i].coneCos == loadedChunks[i].coneCos);
+    }
+
+    // cache with triangle which refers to vertex out of model isn't loaded
+    {
+        auto cachePath = ent::meshCachePath(sourcePath);
+        std::string bytes;
+        {
+            std::ifstream cache{cachePath, std::ios::binary};
+            bytes.assign(std::istreambuf_iterator<char>{cache}, {});
+        }
+        std::string triangleBytes(
+            reinterpret_cast<const char *>(std::to_address(
+                model.trianglesBegin())),
+            static_cast<std::size_t>(model.trianglesEnd() -
+                                     model.trianglesBegin()) *
+                sizeof(Triangle));
+        auto position = bytes.find(triangleBytes);
+        REQUIRE(position != std::string::npos);
+        auto outside = static_cast<uint32_t>(model.verticesCount());
+        std::memcpy(bytes.data() + position, &outside, sizeof(outside));
+        std::ofstream{cachePath, std::ios::binary | std::ios::trunc} << bytes;
+    }
+    ent::Model untouched;
+    CHECK_FALSE(ent::loadMeshCache(sourcePath, untouched));
+    CHECK(untouched.verticesCount() == 0);
+
+    // cache of changed source is stale
+    std::ofstream{source, std::ios::app} << "v 1 0 0\n";
+    CHECK_FALSE(ent::loadMeshCache(sourcePath, loaded));
+
+    std::filesystem::remove(ent::meshCachePath(sourcePath));
+    std::filesystem::remove(source);
+}
+
+TEST_CASE("Mesh cache which can't be read leaves source to be parsed")
+{
+    auto source = std::filesystem::temp_directory_path() / "enttest_broken.obj";
+    auto sourcePath = source.string();
+    auto cachePath = ent::meshCachePath(sourcePath);
+    std::ofstream{source} << "v 0 0 0\n";
+    ent::Model model{{{0, 0, 0, 1}, {1, 0, 0, 1}, {0, 1, 0, 1}},
+                     {Triangle{0, 1, 2}}};
+    ent::saveMeshCache(sourcePath, model);
+
+    // descriptors are used up, so cache can't be opened
+    rlimit limit{};
+    REQUIRE(getrlimit(RLIMIT_NOFILE, &limit) == 0);
+    auto exhausted = limit;
+    exhausted.rlim_cur = 0;
+    REQUIRE(setrlimit(RLIMIT_NOFILE, &exhausted) == 0);
+    bool loaded = true;
+    ent::Model untouched;
+    CHECK_NOTHROW(loaded = ent::loadMeshCache(sourcePath, untouched));
+    REQUIRE(setrlimit(RLIMIT_NOFILE, &limit) == 0);
+    CHECK_FALSE(loaded);
+    CHECK(untouched.verticesCount() == 0);
+
+    // the same cache is read when it can be opened
+    REQUIRE(ent::loadMeshCache(sourcePath, untouched));
+    CHECK(untouched.verticesCount() == 3);
+
+    // cache cut in the middle of its arrays
+    std::filesystem::resize_file(cachePath,
+                                 std::filesystem::file_size(cachePath) / 2);
+    ent::Model truncated;
+    CHECK_NOTHROW(loaded = ent::loadMeshCache(sourcePath, truncated));
+    CHECK_FALSE(loaded);
+    CHECK(truncated.verticesCount() == 0);
+
+    std::filesystem::remove(cachePath);
+    std::filesystem::remove(source);
+}
@@ -3,6 +3,7 @@
 #include <FL/Fl.H>
 #include <FL/Fl_PNG_Image.H>
 #include <FL/fl_draw.H>
+#include <bit>
 #include <cstdint>
 #include <iostream>
 
@@ -22,15 +23,62 @@ ScreenDrawer::ScreenDrawer(int width, int height, eng::ent::Model &&model,
                            eng::ent::LightArray&& lights)
     : Fl_Window{width, height}, _model(std::move(model)), _camera(camera),
       _projection(cameraProjection), _pipe{_model, _camera, _projection},
-      _lights{std::move(lights)},
+      _lights{std::move(lights)}, _lightTiles{},
       _screenArray{static_cast<uint64_t>(width * height)},
-      _indexBuffer(static_cast<uint64_t>(width * height), static_cast<uint32_t>(w())),
-      currentFocus{Focused::Target}, currentStyle{DrawStyle::Mesh}
+      _visibilityBuffer(static_cast<uint64_t>(width * height),
+                        static_cast<uint32_t>(w())),
+      _textureFilter{eng::ent::TextureFilter::Trilinear},
+      _packetShading{eng::shader::PacketShading::Pixels}, _modelStream{},
+      _onModelLoaded{}, currentFocus{Focused::Target},
+      currentStyle{DrawStyle::Mesh}
 {
     _pipe.setZBufferSize(static_cast<uint32_t>(width * height),
                          static_cast<uint32_t>(w()));
 }
 
+ScreenDrawer::~ScreenDrawer() { Fl::remove_timeout(takeModelParts, this); }
+
+// seconds between checks of streamed model
+constexpr double modelStreamInterval = 0.05;
+
+void ScreenDrawer::streamModel(
+    std::unique_ptr<eng::obj::StreamingParser> &&stream,
+    ModelLoaded &&onLoaded)
+{
+    _modelStream = std::move(stream);
+    _onModelLoaded = std::move(onLoaded);
+    Fl::add_timeout(modelStreamInterval, takeModelParts, this);
+}
+
+void ScreenDrawer::takeModelParts(void *drawer)
+{
+    auto &self = *static_cast<ScreenDrawer *>(drawer);
+    try {
+        auto parts = self._modelStream->takeParts();
+        // model is changed only here between frames, so pipeline always
+        // draws complete chunks
+        for (auto &part : parts)
+            self._model.append(
+                std::move(part.vertices), std::move(part.triangles),
+                std::move(part.normals), std::move(part.textureCoords));
+        if (!parts.empty())
+            self.redraw();
+    } catch (const std::exception &e) {
+        std::cerr << "Model isn't read completely: " << e.what() << '\n';
+        self._modelStream.reset();
+        return;
+    }
+    if (!self._modelStream->finished()) {
+        Fl::repeat_timeout(modelStreamInterval, takeModelParts, drawer);
+        return;
+    }
+    self._modelStream.reset();
+    if (self._onModelLoaded) {
+        self._onModelLoaded(self._model, self._camera, self._projection);
+        self.redraw();
+    }
+}
+
 void ScreenDrawer::draw()
 {
     using eng::ent::PixelArray;
@@ -38,19 +86,13 @@ void ScreenDrawer::draw()
     using namespace eng::shader;
 
     _screenArray.fill({0, 0, 0});
-    _indexBuffer.clean();
     eng::ent::PixelArray::pixel color = currentFocus == Focused::Camera
                                             ? PixelArray::pixel{0, 0, 255}
                                             : PixelArray::pixel{0, 255, 0};
-    auto verticesInViewportSpace =
+    const auto &verticesInViewportSpace =
         _pipe.applyVertexTransformations(0, w(), 0, h());
-    auto viewportVerticesIt = verticesInViewportSpace.cbegin();
-    auto indexColorInserter = [=, this](uint64_t  index, vec::Vec3F color){
-      PixelArray::pixel value = {static_cast<uint8_t>(color[0]),
-                                 static_cast<uint8_t>(color[1]),
-                                 static_cast<uint8_t>(color[2])};
-      _screenArray.trySetPixel(index, value);
-    };
+    auto viewportVerticesIt = verticesInViewportSpace.screen.cbegin();
+    _pipe.cullLights(0, w(), 0, h(), _lights, _lightTiles);
     auto colorInserter = [=, this, xSize = static_cast<uint32_t>(w())](
                              long long x, long long y,
                              eng::vec::Vec3F targetColor) {
@@ -61,10 +103,17 @@ void ScreenDrawer::draw()
                                    static_cast<uint8_t>(targetColor[2])};
         _screenArray.trySetPixel(index, value);
     };
+    // covered pixels of row are shaded as one packet
     auto outGenerator = [=](auto&& valueProducer){
-        return [=](uint32_t x, uint32_t y, [[maybe_unused]] floating u,
-                  [[maybe_unused]] floating v, [[maybe_unused]] floating w,
-                  Triangle triangle){colorInserter(x, y, valueProducer(u, v, w, triangle));};
+        return [=](const PixelPacket &packet){
+            auto colors = valueProducer(packet);
+            for (auto mask = packet.mask; mask != 0; mask &= mask - 1) {
+                auto lane = static_cast<std::size_t>(std::countr_zero(mask));
+                colorInserter(static_cast<long long>(packet.x + lane),
+                              packet.y,
+                              {colors.x[lane], colors.y[lane], colors.z[lane]});
+            }
+        };
     };
     auto constantColorInserter =
         [inserter = colorInserter,
@@ -75,26 +124,12 @@ void ScreenDrawer::draw()
     auto albedo = _model.getAlbedo();
     auto eye = _camera.getEye();
     auto shine = _model.getShinePower();
+    _lights.prepareSpecular(shine);
     auto textureCoordsIt = _model.textureCoordsBegin();
-    auto modelMatrix = _model.getModelMatrix();
-    std::vector<Vertex> verticesInWorldSpace{_model.verticesBegin(),
-                                             _model.verticesEnd()};
-    std::transform(
-        verticesInWorldSpace.begin(), verticesInWorldSpace.end(),
-        verticesInWorldSpace.begin(),
-        [modelMatrix = _model.getModelMatrix()](eng::vec::Vec4F vertex) {
-            return modelMatrix * vertex;
-        });
-    std::vector<Normal> normalsInWorldSpace{_model.normalsBegin(),
-                                            _model.normalsEnd()};
-    std::transform(
-        normalsInWorldSpace.begin(), normalsInWorldSpace.end(),
-        normalsInWorldSpace.begin(),
-        [modelMatrix = _model.getModelMatrix()](eng::vec::Vec3F normal) {
-            return (modelMatrix *
-                    vec::Vec4F{normal[0], normal[1], normal[2], 0})
-                .trim<3>();
-        });
+    // cached by model until its matrix or geometry changes
+    const auto &verticesInWorldSpace = _model.getWorldVertices();
+    const auto &normalsInWorldSpace = _model.getWorldNormals();
+    const auto &normalMatrix = _model.getNormalMatrix();
 
     switch (currentStyle) {
     case DrawStyle::Mesh:
@@ -109,7 +144,9 @@ void ScreenDrawer::draw()
                            albedo,
                            eye,
                            shine};
-        _pipe.rasterize(viewportVerticesIt, outGenerator(shader));
+        shader.setLightTiles(&_lightTiles);
+        shader.setPacketShading(_packetShading);
+        _pipe.rasterize(verticesInViewportSpace, outGenerator(shader));
         break;
     }
     case DrawStyle::DeferredPhong:
@@ -120,14 +157,11 @@ void ScreenDrawer::draw()
                                         albedo,
                                         eye,
                                         shine};
-            _pipe.rasterize(viewportVerticesIt, std::ref(_indexBuffer));
-            std::for_each(_indexBuffer.cBegin(), _indexBuffer.cEnd(), [=, index = static_cast<uint64_t>(0)](auto&& fragment)mutable{
-                auto [u, v, w, triangle]  = fragment;
-                if(triangle.cbegin()->vertexOffset != PolygonComponent::invalidOffset){
-                   indexColorInserter(index, shader(u, v, w, triangle));
-                }
-                index++;
-            });
+            shader.setLightTiles(&_lightTiles);
+            _visibilityBuffer.clean();
+            _pipe.rasterize(verticesInViewportSpace,
+                            std::ref(_visibilityBuffer));
+            _pipe.resolve(_visibilityBuffer, shader, colorInserter);
         }
         break;
     case DrawStyle::Texture:
@@ -138,24 +172,16 @@ void ScreenDrawer::draw()
             decltype(auto) specRef = _model.getSpecularMap();
             TextureShader shader{
                 _lights,
-                TextureAlbedo{viewportVerticesIt, textureCoordsIt,
-                              diffRef->data()[0],
-                              static_cast<uint32_t>(diffRef->w()),
-                              static_cast<uint32_t>(diffRef->h()),
-                              static_cast<uint8_t>(diffRef->d())},
-                TextureNormal{modelMatrix, viewportVerticesIt, textureCoordsIt,
-                              normRef->data()[0],
-                              static_cast<uint32_t>(normRef->w()),
-                              static_cast<uint32_t>(normRef->h()),
-                              static_cast<uint8_t>(normRef->d())},
-                TextureSpecular{viewportVerticesIt, textureCoordsIt,
-                                specRef->data()[0],
-                                static_cast<uint32_t>(specRef->w()),
-                                static_cast<uint32_t>(specRef->h()),
-                                static_cast<uint8_t>(specRef->d()),eye,
-                verticesInWorldSpace.cbegin(),
-                shine}};
-            _pipe.rasterize(viewportVerticesIt, outGenerator(shader));
+                TextureAlbedo{viewportVerticesIt, textureCoordsIt, *diffRef,
+                              _textureFilter},
+                TextureNormal{normalMatrix, viewportVerticesIt,
+                              textureCoordsIt, *normRef, _textureFilter},
+                TextureSpecular{viewportVerticesIt, textureCoordsIt, *specRef,
+                                eye, verticesInWorldSpace.cbegin(), shine,
+                                _textureFilter}};
+            shader.setLightTiles(&_lightTiles);
+            shader.setPacketShading(_packetShading);
+            _pipe.rasterize(verticesInViewportSpace, outGenerator(shader));
         }
         break;
     case DrawStyle::FullSpecularWithTextureAlbedo:
@@ -163,16 +189,15 @@ void ScreenDrawer::draw()
             decltype(auto) diffRef = _model.getDiffuseMap();
             FullSpecularWithTextureAlbedo shader{
                 _lights,
-                TextureAlbedo{viewportVerticesIt, textureCoordsIt,
-                              diffRef->data()[0],
-                              static_cast<uint32_t>(diffRef->w()),
-                              static_cast<uint32_t>(diffRef->h()),
-                              static_cast<uint8_t>(diffRef->d())},
+                TextureAlbedo{viewportVerticesIt, textureCoordsIt, *diffRef,
+                              _textureFilter},
                 verticesInWorldSpace.cbegin(),
                 normalsInWorldSpace.cbegin(),
                 eye,
                 shine};
-            _pipe.rasterize(viewportVerticesIt, outGenerator(shader));
+            shader.setLightTiles(&_lightTiles);
+            shader.setPacketShading(_packetShading);
+            _pipe.rasterize(verticesInViewportSpace, outGenerator(shader));
         }
         break;
     case DrawStyle::DeferredPhongWithTextures:
@@ -181,33 +206,20 @@ void ScreenDrawer::draw()
             decltype(auto) diffRef = _model.getDiffuseMap();
             decltype(auto) normRef = _model.getNormalMap();
             decltype(auto) specRef = _model.getSpecularMap();
-            _pipe.rasterize(viewportVerticesIt, std::ref(_indexBuffer));
+            _visibilityBuffer.clean();
+            _pipe.rasterize(verticesInViewportSpace,
+                            std::ref(_visibilityBuffer));
             TextureShader shader{
                 _lights,
-                TextureAlbedo{viewportVerticesIt, textureCoordsIt,
-                              diffRef->data()[0],
-                              static_cast<uint32_t>(diffRef->w()),
-                              static_cast<uint32_t>(diffRef->h()),
-                              static_cast<uint8_t>(diffRef->d())},
-                TextureNormal{modelMatrix, viewportVerticesIt, textureCoordsIt,
-                              normRef->data()[0],
-                              static_cast<uint32_t>(normRef->w()),
-                              static_cast<uint32_t>(normRef->h()),
-                              static_cast<uint8_t>(normRef->d())},
-                TextureSpecular{viewportVerticesIt, textureCoordsIt,
-                                specRef->data()[0],
-                                static_cast<uint32_t>(specRef->w()),
-                                static_cast<uint32_t>(specRef->h()),
-                                static_cast<uint8_t>(specRef->d()),eye,
-                                verticesInWorldSpace.cbegin(),
-                                shine}};
-            std::for_each(_indexBuffer.cBegin(), _indexBuffer.cEnd(), [=, index = static_cast<uint64_t>(0)](auto&& fragment)mutable{
-              auto [u, v, w, triangle]  = fragment;
-              if(triangle.cbegin()->vertexOffset != PolygonComponent::invalidOffset){
-                  indexColorInserter(index, shader(u, v, w, triangle));
-              }
-              index++;
-            });
+                TextureAlbedo{viewportVerticesIt, textureCoordsIt, *diffRef,
+                              _textureFilter},
+                TextureNormal{normalMatrix, viewportVerticesIt,
+                              textureCoordsIt, *normRef, _textureFilter},
+                TextureSpecular{viewportVerticesIt, textureCoordsIt, *specRef,
+                                eye, verticesInWorldSpace.cbegin(), shine,
+                                _textureFilter}};
+            shader.setLightTiles(&_lightTiles);
+            _pipe.resolve(_visibilityBuffer, shader, colorInserter);
         }
     }
     fl_draw_image(_screenArray.data(), 0, 0, w(), h(), 3);
@@ -219,6 +231,10 @@ int ScreenDrawer::handle(int event)
         ChangeFocusToCamera = 'c',
         ChangeFocusToTarget = 't',
         ChangeProjectionType = 'p',
+        ChangeRasterizationMode = 'b',
+        ChangeSpecularMode = 'h',
+        ChangeTextureFilter = 'n',
+        ChangePacketShading = 'k',
         ScaleTarget = 's',
         MoveCameraByDiagonal = 'd',
         ChangeCameraAzimuthal = 'a',
@@ -274,6 +290,45 @@ int ScreenDrawer::handle(int event)
                     ? eng::ent::ProjectionType::Orthographic
                     : eng::ent::ProjectionType::Perspective);
             break;
+        case ChangeRasterizationMode:
+            _pipe.setRasterizationMode(
+                _pipe.getRasterizationMode() ==
+                        eng::pipe::RasterizationMode::Binned
+                    ? eng::pipe::RasterizationMode::Sequential
+                    : eng::pipe::RasterizationMode::Binned);
+            break;
+        case ChangeTextureFilter:
+            switch (_textureFilter) {
+            case eng::ent::TextureFilter::Nearest:
+                _textureFilter = eng::ent::TextureFilter::Bilinear;
+                break;
+            case eng::ent::TextureFilter::Bilinear:
+                _textureFilter = eng::ent::TextureFilter::Trilinear;
+                break;
+            case eng::ent::TextureFilter::Trilinear:
+                _textureFilter = eng::ent::TextureFilter::Nearest;
+                break;
+            }
+            break;
+        case ChangePacketShading:
+            _packetShading =
+                _packetShading == eng::shader::PacketShading::Pixels
+                    ? eng::shader::PacketShading::Packets
+                    : eng::shader::PacketShading::Pixels;
+            break;
+        case ChangeSpecularMode:
+            switch (_lights.getSpecularMode()) {
+            case eng::ent::SpecularMode::Exact:
+                _lights.setSpecularMode(eng::ent::SpecularMode::Table);
+                break;
+            case eng::ent::SpecularMode::Table:
+                _lights.setSpecularMode(eng::ent::SpecularMode::Schlick);
+                break;
+            case eng::ent::SpecularMode::Schlick:
+                _lights.setSpecularMode(eng::ent::SpecularMode::Exact);
+                break;
+            }
+            break;
         case ScaleTarget:
             if (currentFocus == Focused::Target) {
                 eng::floating scaleOn = Fl::event_shift() ? 0.25 : 2;
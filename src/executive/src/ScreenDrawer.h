@@ -5,8 +5,12 @@
 #include "../../entities/src/Light.h"
 #include "../../entities/src/Model.h"
 #include "../../entities/src/Buffers.h"
+#include "../../objparser/src/StreamingParser.h"
 #include "../../pipeline/src/GraphicsPipeline.h"
+#include "../../pipeline/src/Shaders.h"
 #include <FL/Fl_Window.H>
+#include <functional>
+#include <memory>
 
 class ScreenDrawer : public Fl_Window {
 public:
@@ -14,17 +18,34 @@ public:
                  eng::ent::Camera camera,
                  eng::ent::CameraProjection cameraProjection,
                  eng::ent::LightArray&& lights);
+    ~ScreenDrawer() override;
     void draw() override;
     int handle(int) override;
 
+    using ModelLoaded = std::function<void(
+        eng::ent::Model &, eng::ent::Camera &, eng::ent::CameraProjection &)>;
+
+    // the rest of model is added from stream between frames while it's
+    // parsed, onLoaded is called when the whole model is added and it may
+    // fit model and view to it before the next frame
+    void streamModel(std::unique_ptr<eng::obj::StreamingParser> &&stream,
+                     ModelLoaded &&onLoaded);
+
 protected:
+    static void takeModelParts(void *drawer);
+
     eng::ent::Model _model;
     eng::ent::Camera _camera;
     eng::ent::CameraProjection _projection;
     eng::pipe::GraphicsPipeline _pipe;
     eng::ent::LightArray _lights;
+    eng::pipe::LightTiles _lightTiles;
     eng::ent::PixelArray _screenArray;
-    eng::ent::IndexBuffer _indexBuffer;
+    eng::ent::VisibilityBuffer _visibilityBuffer;
+    eng::ent::TextureFilter _textureFilter;
+    eng::shader::PacketShading _packetShading;
+    std::unique_ptr<eng::obj::StreamingParser> _modelStream;
+    ModelLoaded _onModelLoaded;
     enum class Focused;
     enum class DrawStyle;
     Focused currentFocus;
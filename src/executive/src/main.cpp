@@ -1,3 +1,4 @@
+#include "../../entities/src/MeshCache.h"
 #include "../../objparser/src/ObjParser.h"
 #include "ScreenDrawer.h"
 #include <FL/Fl.H>
@@ -5,13 +6,14 @@
 #include <FL/Fl_JPEG_Image.H>
 #include <FL/Fl_PNG_Image.H>
 #include <algorithm>
+#include <chrono>
 #include <cxxopts.hpp>
 #include <memory>
 #include <exception>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
 
 std::string readArgsAndReturnPathToObj(
     int argc, const char *argv[], eng::ent::Model &modelForInit,
@@ -22,10 +24,15 @@ std::string readArgsAndReturnPathToObj(
 void addTextureMaps(eng::ent::Model &model, std::string_view diffuseMapPath,
                     std::string_view normalMapPath,
                     std::string_view specularMapPath);
-void autoPositioning(eng::ent::Model &model, eng::ent::Camera &camera,
-                     eng::ent::CameraProjection &projection);
-
-void initModel(std::string_view pathToObj, eng::ent::Model &model);
+// returns move which is added to model, so it can be taken back when model
+// is fitted again
+eng::vec::Vec3F autoPositioning(eng::ent::Model &model,
+                                eng::ent::Camera &camera,
+                                eng::ent::CameraProjection &projection);
+
+std::unique_ptr<eng::obj::StreamingParser>
+initModel(std::string_view pathToObj, eng::ent::Model &model);
+void saveModelCache(std::string_view pathToObj, const eng::ent::Model &model);
 void getDirectionalLights(eng::ent::LightArray& lights, std::vector<eng::floating> lightsParams);
 void getPointLights(eng::ent::LightArray& lights, std::vector<eng::floating> lightsParams);
 
@@ -47,13 +54,29 @@ int main(int argc, const char *argv[])
 
         auto path = readArgsAndReturnPathToObj(
             argc, argv, model, camera, projection, lights, isAutoPositioning);
-        initModel(path, model);
+        auto modelStream = initModel(path, model);
 
+        eng::vec::Vec3F moved{};
         if (isAutoPositioning)
-            autoPositioning(model, camera, projection);
+            moved = autoPositioning(model, camera, projection);
 
         ScreenDrawer drawer{w,      h - 20,     std::move(model),
                             camera, projection, std::move(lights)};
+        if (modelStream)
+            drawer.streamModel(
+                std::move(modelStream),
+                [path, isAutoPositioning,
+                 moved](eng::ent::Model &loaded, eng::ent::Camera &camera,
+                        eng::ent::CameraProjection &projection) {
+                    // only the first part was fitted before streaming
+                    if (isAutoPositioning) {
+                        loaded.addModelTransformation(
+                            eng::mtr::Matrix::getMove(eng::vec::Vec3F{} -
+                                                      moved));
+                        autoPositioning(loaded, camera, projection);
+                    }
+                    saveModelCache(path, loaded);
+                });
         drawer.end();
         drawer.show();
         return Fl::run();
@@ -76,17 +99,17 @@ void exceptionHandler()
     }
 }
 
-void autoPositioning(eng::ent::Model &model, eng::ent::Camera &camera,
-                     eng::ent::CameraProjection &projection)
+eng::vec::Vec3F autoPositioning(eng::ent::Model &model,
+                                eng::ent::Camera &camera,
+                                eng::ent::CameraProjection &projection)
 {
-    auto [xMin, xMax, yMin, yMax, zMin, zMax] =
-        eng::alg::boundingBox<3>(model.verticesBegin(), model.verticesEnd());
+    auto [xMin, xMax, yMin, yMax, zMin, zMax] = model.getBoundingBox();
     auto modelWidth = xMax - xMin;
     auto modelHeight = yMax - yMin;
     auto modelThickness = zMax - zMin;
 
-    model.addModelTransformation(
-        eng::mtr::Matrix::getMove({0, -modelHeight / 2, -modelThickness / 2}));
+    eng::vec::Vec3F move{0, -modelHeight / 2, -modelThickness / 2};
+    model.addModelTransformation(eng::mtr::Matrix::getMove(move));
 
     std::cout << "Height: " << modelHeight << " Width: " << modelWidth << " Thickness: " << modelThickness << std::endl;
 
@@ -106,6 +129,7 @@ void autoPositioning(eng::ent::Model &model, eng::ent::Camera &camera,
         {radiusForSphere / std::sin(std::min(fovDivided, horizontalFovDivided)),
          projection.getZMin() + radiusForSphere});
     camera.reset({distanceForCamera, 0, 0}, {0, 0, 0}, {0, 1, 0});
+    return move;
 }
 
 std::string readArgsAndReturnPathToObj(
@@ -201,27 +225,42 @@ std::string readArgsAndReturnPathToObj(
     return source;
 }
 
-void initModel(std::string_view pathToObj, eng::ent::Model &model)
+// model is read from cache if it's there, otherwise it's parsed while
+// window is shown already and the rest of model is in returned stream
+std::unique_ptr<eng::obj::StreamingParser>
+initModel(std::string_view pathToObj, eng::ent::Model &model)
 {
-    std::ifstream objFile{};
-
     if (!std::filesystem::is_regular_file(pathToObj)) {
         throw std::logic_error(std::string(pathToObj) + " is not regular file");
     }
+    if (eng::ent::loadMeshCache(pathToObj, model))
+        return nullptr;
+
+    // auto positioning needs bounding box, so the first vertices are waited
+    auto stream = std::make_unique<eng::obj::StreamingParser>(pathToObj);
+    while (model.verticesCount() == 0 && !stream->finished()) {
+        auto parts = stream->takeParts();
+        for (auto &part : parts)
+            model.append(std::move(part.vertices), std::move(part.triangles),
+                         std::move(part.normals),
+                         std::move(part.textureCoords));
+        if (parts.empty())
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    if (!stream->finished())
+        return stream;
+    saveModelCache(pathToObj, model);
+    return nullptr;
+}
 
-    objFile.open(pathToObj.data());
-    if (objFile.bad()) {
-        throw std::logic_error{"Can't open " + std::string(pathToObj) +
-                               " for read"};
+void saveModelCache(std::string_view pathToObj, const eng::ent::Model &model)
+{
+    // model is usable without cache, it's parsed again on next start then
+    try {
+        eng::ent::saveMeshCache(pathToObj, model);
+    } catch (const std::exception &e) {
+        std::cerr << "Mesh cache isn't saved: " << e.what() << '\n';
     }
-    std::vector<eng::Vertex> vertices;
-    std::vector<eng::Normal> normals;
-    std::vector<eng::TextureCoord> textures;
-    std::vector<eng::Triangle> triangles;
-
-    eng::obj::parseStream(objFile, vertices, normals, textures, triangles);
-    model.reset(std::move(vertices), std::move(triangles), std::move(normals),
-                std::move(textures));
 }
 
 std::unique_ptr<Fl_RGB_Image> getRGBImage(std::string_view pathToImage);
@@ -280,7 +319,7 @@ void getDirectionalLights(eng::ent::LightArray& lights, std::vector<eng::floatin
         auto direction = eng::vec::Vec3F {lightsParams[i], lightsParams[i+1], lightsParams[i+2]};
         auto color = eng::vec::Vec3F {lightsParams[i+3], lightsParams[i+4], lightsParams[i+5]};
         auto intensity = lightsParams[i+6];
-        lights.push_back(std::make_unique<eng::ent::DistantLight>(direction, color, intensity));
+        lights.push_back(eng::ent::DistantLight{direction, color, intensity});
     }
 }
 
@@ -296,6 +335,6 @@ void getPointLights(eng::ent::LightArray& lights, std::vector<eng::floating> lig
         auto attenuationConstant = lightsParams[i+7];
         auto attenuationLinear = lightsParams[i+8];
         auto attenuationExp = lightsParams[i+9];
-        lights.push_back(std::make_unique<eng::ent::PointLight>(position, color, intensity, attenuationConstant, attenuationLinear, attenuationExp));
+        lights.push_back(eng::ent::PointLight{position, color, intensity, attenuationConstant, attenuationLinear, attenuationExp});
     }
 }
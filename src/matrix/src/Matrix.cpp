@@ -1,4 +1,6 @@
 #include "Matrix.h"
+#include <cmath>
+#include <utility>
 
 namespace eng::mtr {
 
@@ -42,6 +44,47 @@ bool Matrix::operator!=(const Matrix &matrix) const noexcept
     return matrix_ != matrix.matrix_;
 }
 
+Matrix Matrix::getTransposed() const noexcept
+{
+    MatrixRepresentation result;
+    for (unsigned i = 0; i < MatrixDimension; i++)
+        for (unsigned j = 0; j < MatrixDimension; j++)
+            result[j][i] = matrix_[i][j];
+    return Matrix{result};
+}
+
+std::optional<Matrix> Matrix::getInverse() const noexcept
+{
+    // Gauss-Jordan elimination with partial pivoting
+    auto source = matrix_;
+    auto result = createIdentityMatrix().matrix_;
+    for (unsigned column = 0; column < MatrixDimension; column++) {
+        auto pivot = column;
+        for (auto row = column + 1; row < MatrixDimension; row++)
+            if (std::abs(source[row][column]) > std::abs(source[pivot][column]))
+                pivot = row;
+        if (source[pivot][column] == 0)
+            return std::nullopt;
+        std::swap(source[pivot], source[column]);
+        std::swap(result[pivot], result[column]);
+        auto scale = source[column][column];
+        for (unsigned j = 0; j < MatrixDimension; j++) {
+            source[column][j] /= scale;
+            result[column][j] /= scale;
+        }
+        for (unsigned row = 0; row < MatrixDimension; row++) {
+            if (row == column)
+                continue;
+            auto factor = source[row][column];
+            for (unsigned j = 0; j < MatrixDimension; j++) {
+                source[row][j] -= factor * source[column][j];
+                result[row][j] -= factor * result[column][j];
+            }
+        }
+    }
+    return Matrix{result};
+}
+
 Matrix Matrix::createIdentityMatrix()
 {
     return Matrix{{{{1.0f, 0.0f, 0.0f, 0.0f},
@@ -2,6 +2,7 @@
 #include "../../base/src/eng.h"
 #include "../../vector/src/DimensionalVector.h"
 #include <array>
+#include <optional>
 
 namespace eng::mtr {
 
@@ -31,6 +32,17 @@ public:
 
     bool operator!=(const Matrix &matrix) const noexcept;
 
+    [[nodiscard]] const MatrixRepresentation &
+    getRepresentation() const noexcept
+    {
+        return matrix_;
+    }
+
+    [[nodiscard]] Matrix getTransposed() const noexcept;
+
+    // nullopt for singular matrix
+    [[nodiscard]] std::optional<Matrix> getInverse() const noexcept;
+
     static Matrix createIdentityMatrix();
 
     static Matrix getMove(Vec3F moveVector);
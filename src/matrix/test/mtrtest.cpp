@@ -29,6 +29,29 @@ TEST_CASE("Matrix multiplication with matrix")
     REQUIRE_EQ(expected, result);
 }
 
+TEST_CASE("Matrix transposition")
+{
+    Matrix a{{{{1, 2, 3, 4}, {5, 6, 7, 8}, {5, 2, 6, 7}, {8, 1, 5, 7}}}};
+    Matrix expected{{{{1, 5, 5, 8}, {2, 6, 2, 1}, {3, 7, 6, 5}, {4, 8, 7, 7}}}};
+
+    REQUIRE_EQ(expected, a.getTransposed());
+    REQUIRE_EQ(a, a.getTransposed().getTransposed());
+}
+
+TEST_CASE("Matrix inversion")
+{
+    auto transformation = Matrix::getMove({1, -2, 3}) *
+                          Matrix::getRotateY(0.7f) *
+                          Matrix::getScale({2, 0.5f, 4});
+    auto inverse = transformation.getInverse();
+    REQUIRE(inverse.has_value());
+    Vec4F vector{3, 1, -2, 1};
+    auto result = *inverse * (transformation * vector);
+    for (unsigned i = 0; i < 4; i++)
+        CHECK(result[i] == doctest::Approx(vector[i]).epsilon(1e-5));
+    CHECK(!Matrix::getScale({1, 0, 1}).getInverse().has_value());
+}
+
 TEST_CASE("Vector multiplication with Scale")
 {
     Vec4F vector{3, 2, 1, 1}, expected{1.5, 4, 1, 1};
@@ -1,101 +1,173 @@
 #pragma once
 
-#include "../../algorithm/src/alg.h"
 #include "../../base/src/Elements.h"
+#include "../../base/src/MappedFile.h"
+#include "../../parallel/src/WorkerPool.h"
 #include "ParsingFunctions.h"
+#include <algorithm>
+#include <array>
 #include <istream>
 #include <iterator>
+#include <ranges>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace eng::obj {
 
 template <typename VertexContainer, typename NormalContainer,
           typename TextureCoordContainer, typename PolygonContainer>
-    requires std::same_as<typename VertexContainer::value_type, Vertex> &&
-             std::same_as<typename PolygonContainer::value_type, Triangle> &&
-             std::same_as<typename NormalContainer::value_type, Normal> &&
-             std::same_as<typename TextureCoordContainer::value_type,
-                          TextureCoord>
-void parseStream(std::istream &stream, VertexContainer &vertices,
-                 NormalContainer &normals, TextureCoordContainer &textCoord,
-                 PolygonContainer &polygons)
+concept ObjContainers =
+    std::same_as<typename VertexContainer::value_type, Vertex> &&
+    std::same_as<typename PolygonContainer::value_type, Face> &&
+    std::same_as<typename NormalContainer::value_type, Normal> &&
+    std::same_as<typename TextureCoordContainer::value_type, TextureCoord>;
+
+template <typename Container>
+void reserveMore(Container &container, std::size_t count)
 {
+    if constexpr (requires { container.reserve(count); })
+        container.reserve(container.size() + count);
+}
+
+// bits of RelativeCorner::offsets
+enum RelativeOffset : unsigned {
+    RelativeVertex = 1,
+    RelativeNormal = 2,
+    RelativeTextureCoord = 4
+};
+
+// corner of triangle which has offsets found from negative indexes
+struct RelativeCorner {
+    std::size_t triangle, corner;
+    unsigned offsets;
+};
+
+// count of vertices, normals and texture coordinates
+using ElementsBase = std::array<ssize_t, 3>;
+
+/*
+ * Moves offsets of corner which were found from negative indexes by elements
+ * which precede them, offset which is still before the first element is
+ * invalidOffset.
+ */
+inline void resolveRelative(PolygonComponent &component, unsigned offsets,
+                            const ElementsBase &base) noexcept
+{
+    auto resolve = [](ssize_t &offset, ssize_t elementsBefore) {
+        offset += elementsBefore;
+        if (offset < 0)
+            offset = PolygonComponent::invalidOffset;
+    };
+    if (offsets & RelativeVertex)
+        resolve(component.vertexOffset, base[0]);
+    if (offsets & RelativeNormal)
+        resolve(component.normalOffset, base[1]);
+    if (offsets & RelativeTextureCoord)
+        resolve(component.textureCoordinatesOffset, base[2]);
+}
+
+// resolves corners which parseLines reported for triangles
+inline void resolveRelative(std::vector<Face> &triangles,
+                            const std::vector<RelativeCorner> &corners,
+                            const ElementsBase &base) noexcept
+{
+    for (auto [triangle, corner, offsets] : corners)
+        resolveRelative(triangles[triangle][corner], offsets, base);
+}
+
+/*
+ * Parses OBJ text in place. Containers are reserved by quick count of lines
+ * before parsing, polygon is triangulated as it's read, so neither line nor
+ * polygon is copied. Negative index is relative to elements already in
+ * containers, -1 is the last one; onRelative(RelativeCorner) is called for
+ * every corner of triangle with such index after triangle is appended. Its
+ * offsets may be negative, resolveRelative moves them by elements which
+ * precede containers.
+ */
+template <typename VertexContainer, typename NormalContainer,
+          typename TextureCoordContainer, typename PolygonContainer,
+          typename OnRelative>
+    requires ObjContainers<VertexContainer, NormalContainer,
+                           TextureCoordContainer, PolygonContainer>
+void parseLines(std::string_view buffer, VertexContainer &vertices,
+                NormalContainer &normals, TextureCoordContainer &textCoord,
+                PolygonContainer &polygons, OnRelative onRelative)
+{
+    auto count = countElements(buffer);
+    reserveMore(vertices, count.vertices);
+    reserveMore(normals, count.normals);
+    reserveMore(textCoord, count.textureCoords);
+    reserveMore(polygons, count.polygons);
+
     auto vertexInserter = std::back_inserter(vertices);
     auto normalInserter = std::back_inserter(normals);
     auto textureInserter = std::back_inserter(textCoord);
     auto polygonInserter = std::back_inserter(polygons);
 
-    auto vertexParser = [&](std::string_view stringRep) {
-        vertexInserter = strToVertex(stringRep);
-    };
-
-    auto normalParser = [&](std::string_view stringRep) {
-        normalInserter = strToNormal(stringRep);
+    auto toOffset = [](integral index, std::size_t parsed) -> integral {
+        if (index == 0)
+            return PolygonComponent::invalidOffset;
+        return index < 0 ? static_cast<integral>(parsed) + index : index - 1;
     };
-    auto textureParser = [&](std::string_view stringRep) {
-        textureInserter = strToTextureCoord(stringRep);
-    };
-
     auto polygonParser = [&](std::string_view stringRep) {
-        const auto indexes = obj::strToPolygonIndexesVector(stringRep);
-        Polygon newPolygon{indexes.size()};
-        auto polygonIterator = newPolygon.begin();
-        for (auto [vertexIndex, normalIndex, textureCoordIndex] : indexes) {
-            vertexIndex =
-                vertexIndex < 0
-                    ? static_cast<eng::integral>(
-                          vertices.size() +
-                          static_cast<size_t>(std::abs(vertexIndex)) - 2)
-                    : vertexIndex - 1;
-            normalIndex =
-                normalIndex == 0 ? PolygonComponent::invalidOffset
-                : normalIndex < 0
-                    ? static_cast<eng::integral>(
-                          normals.size() +
-                          static_cast<size_t>(std::abs(normalIndex)) - 2)
-                    : normalIndex - 1;
-            textureCoordIndex =
-                textureCoordIndex == 0 ? PolygonComponent::invalidOffset
-                : textureCoordIndex < 0
-                    ? static_cast<eng::integral>(
-                          textCoord.size() +
-                          static_cast<size_t>(std::abs(textureCoordIndex)) - 2)
-                    : (textureCoordIndex - 1);
-
-            *polygonIterator = {vertexIndex, normalIndex, textureCoordIndex};
-            ++polygonIterator;
-        }
-
-        if (newPolygon.size() == 3) {
-            polygonInserter = {newPolygon[0], newPolygon[1], newPolygon[2]};
-        } else {
-            alg::polygonTriangulation(newPolygon.begin(), newPolygon.end(),
-                                      polygonInserter);
+        auto first = stringRep.data();
+        auto last = stringRep.data() + stringRep.size();
+        // triangles of fan share the first vertex and the previous one
+        std::array<PolygonComponent, 2> fan{};
+        std::array<unsigned, 2> fanRelative{};
+        std::size_t corners = 0;
+        for (PolygonIndexes indexes{};
+             nextPolygonIndexes(first, last, indexes); corners++) {
+            PolygonComponent component{
+                toOffset(indexes.vertexIndex, vertices.size()),
+                toOffset(indexes.normalIndex, normals.size()),
+                toOffset(indexes.textureCoordinatesIndex, textCoord.size())};
+            auto relative =
+                (indexes.vertexIndex < 0 ? RelativeVertex : 0u) |
+                (indexes.normalIndex < 0 ? RelativeNormal : 0u) |
+                (indexes.textureCoordinatesIndex < 0 ? RelativeTextureCoord
+                                                     : 0u);
+            if (corners >= 2) {
+                polygonInserter = {fan[0], fan[1], component};
+                std::array triangleRelative{fanRelative[0], fanRelative[1],
+                                            relative};
+                for (std::size_t corner = 0; corner < 3; corner++)
+                    if (triangleRelative[corner] != 0)
+                        onRelative(RelativeCorner{polygons.size() - 1, corner,
+                                                  triangleRelative[corner]});
+            }
+            fan[corners == 0 ? 0 : 1] = component;
+            fanRelative[corners == 0 ? 0 : 1] = relative;
         }
     };
 
-    for (std::string line{}; stream.good() && std::getline(stream, line);) {
+    for (std::size_t begin = 0; begin < buffer.size();) {
+        auto end = buffer.find('\n', begin);
+        if (end == std::string_view::npos)
+            end = buffer.size();
+        auto line = buffer.substr(begin, end - begin);
+        begin = end + 1;
         if (line.ends_with('\r'))
-            line.pop_back();
-        auto delimiterPosition = line.find(objectTypeDelimiter);
-        std::string_view element{line.data(), delimiterPosition};
+            line.remove_suffix(1);
+        auto delimiterPosition =
+            std::min(line.find(objectTypeDelimiter), line.find('\t'));
+        if (delimiterPosition == std::string_view::npos)
+            continue;
+        auto element = line.substr(delimiterPosition + 1);
 
-        switch (strToType(element)) {
+        switch (strToType(line.substr(0, delimiterPosition))) {
         case Object::Vertex:
-            vertexParser({line.data() + delimiterPosition + 1,
-                          line.size() - delimiterPosition - 1});
+            vertexInserter = strToVertex(element);
             break;
         case Object::Normal:
-            normalParser({line.data() + delimiterPosition + 1,
-                          line.size() - delimiterPosition - 1});
+            normalInserter = strToNormal(element);
             break;
         case Object::TextureCoord:
-            textureParser({line.data() + delimiterPosition + 1,
-                           line.size() - delimiterPosition - 1});
+            textureInserter = strToTextureCoord(element);
             break;
         case Object::Polygon:
-            polygonParser({line.data() + delimiterPosition + 1,
-                           line.size() - delimiterPosition - 1});
+            polygonParser(element);
             break;
         default:
             break;
@@ -103,4 +175,141 @@ void parseStream(std::istream &stream, VertexContainer &vertices,
     }
 }
 
+template <typename VertexContainer, typename NormalContainer,
+          typename TextureCoordContainer, typename PolygonContainer>
+void parseBuffer(std::string_view buffer, VertexContainer &vertices,
+                 NormalContainer &normals, TextureCoordContainer &textCoord,
+                 PolygonContainer &polygons)
+{
+    // containers have all elements before triangle, which is the last one
+    parseLines(buffer, vertices, normals, textCoord, polygons,
+               [&polygons](RelativeCorner corner) {
+                   resolveRelative(polygons.back()[corner.corner],
+                                   corner.offsets, {});
+               });
+}
+
+// appends elements of chunks in order, contiguous container is resized once
+// and chunks are copied to their places in parallel
+template <typename Container, typename Chunk, typename Elements>
+void appendChunks(Container &container, par::WorkerPool &pool,
+                  std::vector<Chunk> &chunks, Elements Chunk::*elements)
+{
+    if constexpr (std::ranges::contiguous_range<Container> &&
+                  requires { container.resize(container.size()); }) {
+        std::vector<std::size_t> offsets{container.size()};
+        for (const auto &chunk : chunks)
+            offsets.push_back(offsets.back() + (chunk.*elements).size());
+        container.resize(offsets.back());
+        pool.parallelFor(chunks.size(), [&](std::size_t i) {
+            auto &part = chunks[i].*elements;
+            std::copy(part.cbegin(), part.cend(),
+                      container.begin() +
+                          static_cast<std::ptrdiff_t>(offsets[i]));
+            part = {};
+        });
+    } else {
+        std::size_t count = 0;
+        for (const auto &chunk : chunks)
+            count += (chunk.*elements).size();
+        reserveMore(container, count);
+        for (auto &chunk : chunks) {
+            auto &part = chunk.*elements;
+            std::copy(part.cbegin(), part.cend(),
+                      std::back_inserter(container));
+            part = {};
+        }
+    }
+}
+
+/*
+ * The same result as sequential parseBuffer. Buffer is split at line ends,
+ * chunks are parsed by workers of pool into their own containers, then
+ * offsets found from negative indexes are moved by elements of previous
+ * chunks and chunks are appended in order. Buffer which is too small for
+ * two chunks is parsed sequentially.
+ */
+template <typename VertexContainer, typename NormalContainer,
+          typename TextureCoordContainer, typename PolygonContainer>
+    requires ObjContainers<VertexContainer, NormalContainer,
+                           TextureCoordContainer, PolygonContainer>
+void parseBuffer(std::string_view buffer, par::WorkerPool &pool,
+                 VertexContainer &vertices, NormalContainer &normals,
+                 TextureCoordContainer &textCoord, PolygonContainer &polygons)
+{
+    auto chunks = splitLines(buffer, pool.size() * chunksPerThread);
+    if (chunks.size() < 2) {
+        parseBuffer(buffer, vertices, normals, textCoord, polygons);
+        return;
+    }
+
+    struct Chunk {
+        std::vector<Vertex> vertices;
+        std::vector<Normal> normals;
+        std::vector<TextureCoord> textureCoords;
+        std::vector<Face> triangles;
+        std::vector<RelativeCorner> relative;
+    };
+    std::vector<Chunk> parsed(chunks.size());
+    pool.parallelFor(chunks.size(), [&](std::size_t i) {
+        auto &chunk = parsed[i];
+        parseLines(chunks[i], chunk.vertices, chunk.normals,
+                   chunk.textureCoords, chunk.triangles,
+                   [&chunk](RelativeCorner corner) {
+                       chunk.relative.push_back(corner);
+                   });
+    });
+
+    // chunk resolved negative indexes against its own elements
+    std::vector<ElementsBase> bases(parsed.size());
+    ElementsBase base{static_cast<ssize_t>(vertices.size()),
+                                static_cast<ssize_t>(normals.size()),
+                                static_cast<ssize_t>(textCoord.size())};
+    for (std::size_t i = 0; i < parsed.size(); i++) {
+        bases[i] = base;
+        base[0] += static_cast<ssize_t>(parsed[i].vertices.size());
+        base[1] += static_cast<ssize_t>(parsed[i].normals.size());
+        base[2] += static_cast<ssize_t>(parsed[i].textureCoords.size());
+    }
+    pool.parallelFor(parsed.size(), [&](std::size_t i) {
+        resolveRelative(parsed[i].triangles, parsed[i].relative, bases[i]);
+    });
+
+    appendChunks(vertices, pool, parsed, &Chunk::vertices);
+    appendChunks(normals, pool, parsed, &Chunk::normals);
+    appendChunks(textCoord, pool, parsed, &Chunk::textureCoords);
+    appendChunks(polygons, pool, parsed, &Chunk::triangles);
+}
+
+template <typename VertexContainer, typename NormalContainer,
+          typename TextureCoordContainer, typename PolygonContainer>
+void parseStream(std::istream &stream, VertexContainer &vertices,
+                 NormalContainer &normals, TextureCoordContainer &textCoord,
+                 PolygonContainer &polygons)
+{
+    std::string buffer{std::istreambuf_iterator<char>{stream}, {}};
+    parseBuffer(buffer, vertices, normals, textCoord, polygons);
+}
+
+// file is mapped to memory and parsed without copying
+template <typename VertexContainer, typename NormalContainer,
+          typename TextureCoordContainer, typename PolygonContainer>
+void parseFile(std::string_view path, VertexContainer &vertices,
+               NormalContainer &normals, TextureCoordContainer &textCoord,
+               PolygonContainer &polygons)
+{
+    MappedFile file{path};
+    parseBuffer(file.view(), vertices, normals, textCoord, polygons);
+}
+
+template <typename VertexContainer, typename NormalContainer,
+          typename TextureCoordContainer, typename PolygonContainer>
+void parseFile(std::string_view path, par::WorkerPool &pool,
+               VertexContainer &vertices, NormalContainer &normals,
+               TextureCoordContainer &textCoord, PolygonContainer &polygons)
+{
+    MappedFile file{path};
+    parseBuffer(file.view(), pool, vertices, normals, textCoord, polygons);
+}
+
 } // namespace eng::obj
@@ -1,74 +1,135 @@
 #include "ParsingFunctions.h"
-#include <cstdlib>
+#include <algorithm>
+#include <charconv>
 #include <string_view>
 
 namespace eng::obj {
 
-template <size_t size>
-auto parseFloatString(std::string_view stringRep, char **lastPos)
+namespace {
+
+const char *skipBlanks(const char *first, const char *last)
+{
+    while (first != last && isBlank(*first))
+        first++;
+    return first;
+}
+
+// parses number after blanks; first is moved past it, or past the token if
+// it isn't a number, value is left unchanged then
+template <typename Number>
+bool parseNumber(const char *&first, const char *last, Number &value)
+{
+    first = skipBlanks(first, last);
+    if (first == last)
+        return false;
+    // from_chars doesn't accept plus sign
+    auto begin = first + (*first == '+' ? 1 : 0);
+    auto [end, error] = std::from_chars(begin, last, value);
+    if (error == std::errc{}) {
+        first = end;
+        return true;
+    }
+    while (first != last && !isBlank(*first) && *first != '/')
+        first++;
+    return true;
+}
+
+template <std::size_t size>
+std::size_t parseFloats(std::string_view stringRep,
+                        std::array<floating, size> &values)
+{
+    auto first = stringRep.data(), last = stringRep.data() + stringRep.size();
+    std::size_t parsed = 0;
+    while (parsed < size && parseNumber(first, last, values[parsed]))
+        parsed++;
+    return parsed;
+}
+
+} // namespace
+
+ElementsCount countElements(std::string_view buffer)
 {
-    std::array<eng::floating, size> result{};
-    char *nextPos = const_cast<char *>(stringRep.data());
-    for (unsigned i = 0; i < size; i++) {
-        if (i % 2) {
-            result[i] = std::strtof(*lastPos, &nextPos);
-        } else {
-            result[i] = std::strtof(nextPos, lastPos);
+    ElementsCount count{};
+    for (std::size_t begin = 0; begin < buffer.size();) {
+        auto end = buffer.find('\n', begin);
+        if (end == std::string_view::npos)
+            end = buffer.size();
+        auto line = buffer.substr(begin, end - begin);
+        if (line.size() > 1 && line[0] == 'v') {
+            if (isBlank(line[1]))
+                count.vertices++;
+            else if (line[1] == 'n')
+                count.normals++;
+            else if (line[1] == 't')
+                count.textureCoords++;
+        } else if (line.size() > 1 && line[0] == 'f' && isBlank(line[1])) {
+            count.polygons++;
         }
+        begin = end + 1;
     }
-    return result;
+    return count;
+}
+
+std::vector<std::string_view> splitLines(std::string_view buffer,
+                                         std::size_t count)
+{
+    count = std::clamp<std::size_t>(buffer.size() / minChunkSize, 1,
+                                    std::max<std::size_t>(count, 1));
+    std::vector<std::string_view> parts;
+    parts.reserve(count);
+    std::size_t begin = 0;
+    for (std::size_t part = 1; part < count && begin < buffer.size();
+         part++) {
+        auto end = buffer.find('\n', std::max(begin, buffer.size() * part /
+                                                         count));
+        if (end == std::string_view::npos)
+            break;
+        parts.push_back(buffer.substr(begin, end + 1 - begin));
+        begin = end + 1;
+    }
+    if (begin < buffer.size())
+        parts.push_back(buffer.substr(begin));
+    return parts;
 }
 
 Vertex strToVertex(std::string_view stringRep)
 {
-    char *lastPos = nullptr;
-    auto v = parseFloatString<3>(stringRep, &lastPos);
-    Vertex newVertex{v[0], v[1], v[2], 1.0f};
-    if (lastPos != stringRep.end())
-        newVertex[3] = std::strtof(lastPos, nullptr);
-    return newVertex;
+    std::array<floating, 4> values{0, 0, 0, 1};
+    parseFloats(stringRep, values);
+    return {values[0], values[1], values[2], values[3]};
 }
 
 Normal strToNormal(std::string_view stringRep)
 {
-    char *p;
-    auto v = parseFloatString<3>(stringRep, &p);
-    return {v[0], v[1], v[2]};
+    std::array<floating, 3> values{};
+    parseFloats(stringRep, values);
+    return {values[0], values[1], values[2]};
 }
 
 TextureCoord strToTextureCoord(std::string_view stringRep)
 {
-    TextureCoord result{};
-    char *lastPos = nullptr, *nextPos = const_cast<char *>(stringRep.data());
-    result[0] = std::strtof(nextPos, &lastPos);
-    if (lastPos != stringRep.end()) {
-        result[1] = std::strtof(lastPos, &nextPos);
-        if (nextPos != stringRep.end()) {
-            result[2] = std::strtof(nextPos, &lastPos);
-        }
-    }
-    return result;
+    std::array<floating, 3> values{};
+    parseFloats(stringRep, values);
+    return {values[0], values[1], values[2]};
 }
 
-std::vector<PolygonIndexes>
-strToPolygonIndexesVector(std::string_view stringRep)
+bool nextPolygonIndexes(const char *&first, const char *last,
+                        PolygonIndexes &indexes)
 {
-    std::vector<PolygonIndexes> indexesVector;
-    char *lastPos = const_cast<char *>(stringRep.data());
-    long vertexIndex{}, normalIndex{}, textureCoordinatesIndex{};
-    while ((vertexIndex = std::strtoll(lastPos, &lastPos, 10)) != 0) {
-        if (*lastPos == '/') {
-            lastPos++;
-            textureCoordinatesIndex = std::strtoll(lastPos, &lastPos, 10);
-            if (*lastPos == '/') {
-                lastPos++;
-                normalIndex = std::strtoll(lastPos, &lastPos, 10);
-            }
+    indexes = {};
+    if (!parseNumber(first, last, indexes.vertexIndex) ||
+        indexes.vertexIndex == 0)
+        return false;
+    if (first != last && *first == '/') {
+        first++;
+        if (first != last && *first != '/')
+            parseNumber(first, last, indexes.textureCoordinatesIndex);
+        if (first != last && *first == '/') {
+            first++;
+            parseNumber(first, last, indexes.normalIndex);
         }
-        indexesVector.emplace_back(vertexIndex, normalIndex,
-                                   textureCoordinatesIndex);
     }
-    return indexesVector;
+    return true;
 }
 
 } // namespace eng::obj
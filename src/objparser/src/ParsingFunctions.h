@@ -2,6 +2,7 @@
 
 #include "../../base/src/Elements.h"
 #include <string_view>
+#include <vector>
 namespace eng::obj {
 
 constexpr char objectTypeDelimiter = ' ';
@@ -25,11 +26,38 @@ inline Object strToType(std::string_view str)
     return Object::Nothing;
 }
 
+inline bool isBlank(char symbol) { return symbol == ' ' || symbol == '\t'; }
+
+// numbers of elements of each type, they are counted by the first symbols
+// of lines, so it's quick pass before parsing
+struct ElementsCount {
+    std::size_t vertices, normals, textureCoords, polygons;
+};
+ElementsCount countElements(std::string_view buffer);
+
+// chunks of parallel parsing, there're several for each thread, so threads
+// which finished earlier take the rest, but every chunk is at least
+// minChunkSize bytes to pay off its merging
+constexpr std::size_t chunksPerThread = 4;
+constexpr std::size_t minChunkSize = 1 << 20;
+
+// up to count parts of buffer of about equal size, each but the last one
+// ends right after line end
+std::vector<std::string_view> splitLines(std::string_view buffer,
+                                         std::size_t count);
+
+/*
+ * Parsers of the text after type of element. They don't depend on locale
+ * and don't allocate. Number which can't be parsed is left unchanged, so it
+ * keeps its default and malformed element doesn't stop parsing of file.
+ */
 Vertex strToVertex(std::string_view stringRep);
 Normal strToNormal(std::string_view stringRep);
 TextureCoord strToTextureCoord(std::string_view stringRep);
 
-std::vector<PolygonIndexes>
-strToPolygonIndexesVector(std::string_view stringRep);
+// indexes of the next vertex of polygon as they're written, absent index is
+// zero, first is moved past it; returns false if there are no vertices left
+bool nextPolygonIndexes(const char *&first, const char *last,
+                        PolygonIndexes &indexes);
 
-} // namespace eng::obj
\ No newline at end of file
+} // namespace eng::obj
@@ -0,0 +1,119 @@
+#include "StreamingParser.h"
+#include "../../parallel/src/WorkerPool.h"
+#include "ObjParser.h"
+#include <algorithm>
+#include <array>
+
+namespace eng::obj {
+
+StreamingParser::StreamingParser(std::string_view path)
+    : _file{path},
+      _text{splitLines(_file.view(), _file.view().size() / streamPartSize)},
+      _parts(_text.size()), _taken{0}, _error{}, _published{0},
+      _failed{false},
+      _thread{[this](const std::stop_token &stop) { parse(stop); }}
+{}
+
+std::vector<StreamingParser::Part> StreamingParser::takeParts()
+{
+    // every part published before failure is seen once failure is seen
+    auto failed = _failed.load(std::memory_order_acquire);
+    auto published = _published.load(std::memory_order_acquire);
+    std::vector<Part> parts;
+    for (; _taken < published; _taken++)
+        parts.push_back(std::move(_parts[_taken]));
+    if (failed && parts.empty())
+        std::rethrow_exception(_error);
+    return parts;
+}
+
+bool StreamingParser::finished() const noexcept
+{
+    return _taken == _parts.size();
+}
+
+void StreamingParser::parse(const std::stop_token &stop)
+{
+    try {
+        par::WorkerPool pool;
+        struct Parsed {
+            std::vector<Vertex> vertices;
+            std::vector<Normal> normals;
+            std::vector<TextureCoord> textureCoords;
+            std::vector<Face> faces;
+            std::vector<RelativeCorner> relative;
+        };
+        std::vector<Parsed> parsed(pool.size());
+        // elements of parsed parts, which faces of next ones refer to
+        std::vector<Vertex> vertices;
+        std::vector<Normal> normals;
+        std::vector<TextureCoord> textureCoords;
+        VertexWelder welder;
+        std::vector<Face> waiting;
+        auto refersAhead = [&](const Face &face) {
+            return std::ranges::any_of(face, [&](const auto &component) {
+                return component.vertexOffset >= std::ssize(vertices) ||
+                       component.normalOffset >= std::ssize(normals) ||
+                       component.textureCoordinatesOffset >=
+                           std::ssize(textureCoords);
+            });
+        };
+
+        // the next parts are parsed by pool together, then they're welded
+        // and published in order
+        for (std::size_t first = 0;
+             first < _parts.size() && !stop.stop_requested();
+             first += pool.size()) {
+            auto last = std::min<std::size_t>(first + pool.size(),
+                                              _parts.size());
+            pool.parallelFor(last - first, [&, first](std::size_t i) {
+                auto &part = parsed[i];
+                part = {};
+                parseLines(_text[first + i], part.vertices, part.normals,
+                           part.textureCoords, part.faces,
+                           [&part](RelativeCorner corner) {
+                               part.relative.push_back(corner);
+                           });
+            });
+
+            for (auto i = first; i < last; i++) {
+                auto &part = parsed[i - first];
+                // part resolved negative indexes against its own elements
+                resolveRelative(part.faces, part.relative,
+                                {std::ssize(vertices), std::ssize(normals),
+                                 std::ssize(textureCoords)});
+                vertices.insert(vertices.end(), part.vertices.cbegin(),
+                                part.vertices.cend());
+                normals.insert(normals.end(), part.normals.cbegin(),
+                               part.normals.cend());
+                textureCoords.insert(textureCoords.end(),
+                                     part.textureCoords.cbegin(),
+                                     part.textureCoords.cend());
+
+                // the last part takes the rest of faces, even if they refer
+                // to elements which aren't in file
+                auto &faces = part.faces;
+                faces.insert(faces.end(), waiting.cbegin(), waiting.cend());
+                waiting.clear();
+                if (i + 1 < _parts.size()) {
+                    auto ahead = std::stable_partition(
+                        faces.begin(), faces.end(),
+                        [&refersAhead](const Face &face) {
+                            return !refersAhead(face);
+                        });
+                    waiting.assign(ahead, faces.end());
+                    faces.erase(ahead, faces.end());
+                }
+                _parts[i] =
+                    welder.weld(faces, vertices, normals, textureCoords);
+                part = {};
+                _published.store(i + 1, std::memory_order_release);
+            }
+        }
+    } catch (...) {
+        _error = std::current_exception();
+        _failed.store(true, std::memory_order_release);
+    }
+}
+
+} // namespace eng::obj
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../../base/src/Elements.h"
+#include "../../base/src/MappedFile.h"
+#include "VertexWelder.h"
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace eng::obj {
+
+// file is split on parts of about such size, so the first ones are ready
+// soon after parsing starts
+constexpr std::size_t streamPartSize = 4 << 20;
+
+/*
+ * Parses mapped OBJ file on its own thread and publishes it welded part by
+ * part in order of file, so beginning of model can be used before the whole
+ * file is read. Indexes of triangles are indexes in the whole model, and
+ * every vertex which triangle refers to is in the same part or in previous
+ * one: face which refers to element defined later is welded with part which
+ * has it. Parsing thread fills slots of parts and then increases counter of
+ * published ones, so neither thread waits for the other. Destructor stops
+ * parsing and waits for thread. Throws std::system_error if file can't be
+ * mapped.
+ */
+class StreamingParser final {
+public:
+    // vertices which are new in part and its triangles
+    using Part = WeldedMesh;
+
+    explicit StreamingParser(std::string_view path);
+    StreamingParser(const StreamingParser &) = delete;
+    StreamingParser &operator=(const StreamingParser &) = delete;
+
+    // parts which were published since previous call, in order of file;
+    // exception of parsing is rethrown after parts before it are taken
+    [[nodiscard]] std::vector<Part> takeParts();
+
+    // every part is taken
+    [[nodiscard]] bool finished() const noexcept;
+
+private:
+    void parse(const std::stop_token &stop);
+
+    MappedFile _file;
+    std::vector<std::string_view> _text;
+    std::vector<Part> _parts;
+    std::size_t _taken;
+    std::exception_ptr _error;
+    std::atomic<std::size_t> _published;
+    std::atomic<bool> _failed;
+    // the last member, so it's stopped before everything it uses is gone
+    std::jthread _thread;
+};
+
+} // namespace eng::obj
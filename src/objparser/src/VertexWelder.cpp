@@ -0,0 +1,80 @@
+#include "VertexWelder.h"
+#include <stdexcept>
+
+namespace eng::obj {
+
+namespace {
+
+// offset of element in array or invalid one
+ssize_t validOffset(ssize_t offset, std::size_t size) noexcept
+{
+    return offset >= 0 && static_cast<std::size_t>(offset) < size
+               ? offset
+               : PolygonComponent::invalidOffset;
+}
+
+} // namespace
+
+WeldedMesh VertexWelder::weld(const std::vector<Face> &faces,
+                              const std::vector<Vertex> &vertices,
+                              const std::vector<Normal> &normals,
+                              const std::vector<TextureCoord> &textureCoords)
+{
+    WeldedMesh mesh;
+    mesh.triangles.reserve(faces.size());
+    _first.resize(vertices.size(), noVertex);
+
+    auto vertexOf = [&](const PolygonComponent &component) {
+        auto position = static_cast<std::size_t>(component.vertexOffset);
+        std::array attributes{
+            validOffset(component.normalOffset, normals.size()),
+            validOffset(component.textureCoordinatesOffset,
+                        textureCoords.size())};
+        for (auto vertex = _first[position]; vertex != noVertex;
+             vertex = _next[vertex])
+            if (_attributes[vertex] == attributes)
+                return vertex;
+
+        if (_next.size() >= noVertex)
+            throw std::length_error{"Too many vertices in model"};
+        auto vertex = static_cast<uint32_t>(_next.size());
+        _next.push_back(_first[position]);
+        _first[position] = vertex;
+        _attributes.push_back(attributes);
+        mesh.vertices.push_back(vertices[position]);
+        if (!normals.empty())
+            mesh.normals.push_back(
+                attributes[0] < 0
+                    ? Normal{}
+                    : normals[static_cast<std::size_t>(attributes[0])]);
+        if (!textureCoords.empty())
+            mesh.textureCoords.push_back(
+                attributes[1] < 0
+                    ? TextureCoord{}
+                    : textureCoords[static_cast<std::size_t>(attributes[1])]);
+        return vertex;
+    };
+
+    for (const auto &face : faces) {
+        bool hasPositions = true;
+        for (const auto &component : face)
+            hasPositions =
+                hasPositions &&
+                validOffset(component.vertexOffset, vertices.size()) >= 0;
+        if (!hasPositions)
+            continue;
+        mesh.triangles.push_back(
+            {vertexOf(face[0]), vertexOf(face[1]), vertexOf(face[2])});
+    }
+    return mesh;
+}
+
+WeldedMesh weld(const std::vector<Face> &faces,
+                const std::vector<Vertex> &vertices,
+                const std::vector<Normal> &normals,
+                const std::vector<TextureCoord> &textureCoords)
+{
+    return VertexWelder{}.weld(faces, vertices, normals, textureCoords);
+}
+
+} // namespace eng::obj
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../../base/src/Elements.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace eng::obj {
+
+// i-th vertex has vertices[i], normals[i] and textureCoords[i], normals or
+// texture coordinates are empty if model has none of them
+struct WeldedMesh {
+    std::vector<Vertex> vertices;
+    std::vector<Normal> normals;
+    std::vector<TextureCoord> textureCoords;
+    std::vector<Triangle> triangles;
+};
+
+/*
+ * Corner of OBJ face refers to position, normal and texture coordinate by
+ * separate offsets. Welder gives every distinct triple of offsets its own
+ * vertex, so triangle is three indexes which are the same for every
+ * attribute. Triples are hashed by position offset: every position has list
+ * of vertices with it, which is usually one or two long. Vertices welded by
+ * previous calls are reused by next ones.
+ */
+class VertexWelder final {
+public:
+    VertexWelder() : _first{}, _next{}, _attributes{} {}
+
+    /*
+     * Welds faces which refer to elements of arrays, they are all elements
+     * read so far. Returns vertices which are new and triangles, which refer
+     * to all welded vertices. Attribute which corner doesn't have or which
+     * isn't in arrays is zero. Face with position which isn't in array is
+     * skipped. Throws std::length_error if vertices don't fit in uint32_t.
+     */
+    [[nodiscard]] WeldedMesh
+    weld(const std::vector<Face> &faces, const std::vector<Vertex> &vertices,
+         const std::vector<Normal> &normals,
+         const std::vector<TextureCoord> &textureCoords);
+
+    // vertices welded by all calls
+    [[nodiscard]] std::size_t size() const noexcept { return _next.size(); }
+
+private:
+    // the first vertex with every position and the next one with the same
+    // position for every vertex, noVertex ends the list
+    std::vector<uint32_t> _first;
+    std::vector<uint32_t> _next;
+    // offsets of normal and texture coordinate of every vertex
+    std::vector<std::array<ssize_t, 2>> _attributes;
+};
+
+// welds the whole model at once
+[[nodiscard]] WeldedMesh weld(const std::vector<Face> &faces,
+                              const std::vector<Vertex> &vertices,
+                              const std::vector<Normal> &normals,
+                              const std::vector<TextureCoord> &textureCoords);
+
+} // namespace eng::obj
@@ -1,15 +1,31 @@
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <sstream>
+#include <string>
+#include <system_error>
+#include <unistd.h>
 #include <vector>
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "../src/ObjParser.h"
+#include "../src/StreamingParser.h"
+#include "../src/VertexWelder.h"
 #include "engConfig.h"
 #include <doctest/doctest.h>
 
 using namespace eng::obj;
 using namespace eng;
 
+// file of test in temporary directory, which isn't shared with test run by
+// other process
+std::filesystem::path temporaryPath(const std::string &name)
+{
+    return std::filesystem::temp_directory_path() /
+           (name + '_' + std::to_string(getpid()) + ".obj");
+}
+
 TEST_CASE("Parsing vertex")
 {
     Vertex expected{-1.3143f, 15.0686f, -1.6458f, 1.0f};
@@ -67,7 +83,7 @@ TEST_CASE("Parse stream completely")
     std::vector<Vertex> vertices;
     std::vector<Normal> normals;
     std::vector<TextureCoord> textures;
-    std::vector<Triangle> polygons;
+    std::vector<Face> polygons;
 
     std::stringstream stream{
         "# comment\nv  -1.3143 15.0686 -1.6458\nvn  "
@@ -93,6 +109,286 @@ TEST_CASE("Parse stream completely")
     }
 }
 
+TEST_CASE("Parse buffer with polygons and relative indexes")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Normal> normals;
+    std::vector<TextureCoord> textures;
+    std::vector<Face> polygons;
+
+    std::string_view buffer{
+        "v 0 0 0\r\nv 1 0 0 0.5\r\nv\t1 1 0\nv 0 1 +0\n"
+        "vn 0 0 1\nvt 0.5\n"
+        "f 1//1 2//1 3//1 4//1\n"
+        "f -4/-1 -2/1 -1/1\n"
+        "s off\nf 1 2 x\nf 1 3"};
+
+    parseBuffer(buffer, vertices, normals, textures, polygons);
+
+    std::vector expectedVertices{Vertex{0, 0, 0, 1}, Vertex{1, 0, 0, 0.5f},
+                                 Vertex{1, 1, 0, 1}, Vertex{0, 1, 0, 1}};
+    std::vector expectedTextures{TextureCoord{0.5f, 0, 0}};
+    CHECK(vertices == expectedVertices);
+    CHECK(textures == expectedTextures);
+    // quad is a fan of two triangles, polygon ends on malformed index and
+    // polygon of two vertices gives nothing
+    REQUIRE(polygons.size() == 3);
+    const std::array<ssize_t, 3> expectedOffsets{0, 2, 3};
+    std::array<ssize_t, 3> vertexOffsets{};
+    for (std::size_t i = 0; i < 3; i++)
+        vertexOffsets[i] = polygons[1][i].vertexOffset;
+    CHECK(vertexOffsets == expectedOffsets);
+    CHECK(polygons[0][2].normalOffset == 0);
+    CHECK(polygons[0][2].textureCoordinatesOffset ==
+          PolygonComponent::invalidOffset);
+    for (std::size_t i = 0; i < 3; i++)
+        vertexOffsets[i] = polygons[2][i].vertexOffset;
+    CHECK(vertexOffsets == expectedOffsets);
+    CHECK(polygons[2][0].textureCoordinatesOffset == 0);
+    CHECK(polygons[2][0].normalOffset == PolygonComponent::invalidOffset);
+}
+
+TEST_CASE("Relative index before the first element is invalid")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Normal> normals;
+    std::vector<TextureCoord> textures;
+    std::vector<Face> polygons;
+
+    parseBuffer("v 0 0 0\nv 1 0 0\nf -5 -6 -7\nf -2 -1 -3//-1\n", vertices,
+                normals, textures, polygons);
+
+    REQUIRE(polygons.size() == 2);
+    for (const auto &component : polygons[0])
+        CHECK(component.vertexOffset == PolygonComponent::invalidOffset);
+    CHECK(polygons[1][0].vertexOffset == 0);
+    CHECK(polygons[1][1].vertexOffset == 1);
+    CHECK(polygons[1][2].vertexOffset == PolygonComponent::invalidOffset);
+    CHECK(polygons[1][2].normalOffset == PolygonComponent::invalidOffset);
+}
+
+TEST_CASE("Parse mapped file")
+{
+    auto path = temporaryPath("objparsertest_mapped");
+    {
+        std::ofstream file{path};
+        file << "v 1 2 3\nv 4 5 6\nv 7 8 9\nf 1 2 3\n";
+    }
+    std::vector<Vertex> vertices;
+    std::vector<Normal> normals;
+    std::vector<TextureCoord> textures;
+    std::vector<Face> polygons;
+
+    parseFile(path.string(), vertices, normals, textures, polygons);
+    std::filesystem::remove(path);
+
+    CHECK(vertices.size() == 3);
+    CHECK(polygons.size() == 1);
+    CHECK_THROWS_AS(parseFile(path.string(), vertices, normals, textures,
+                              polygons),
+                    std::system_error);
+}
+
+// lines of every element type with absolute and relative indexes
+std::string randomObj(std::size_t size, unsigned seed)
+{
+    std::mt19937 mt(seed);
+    std::string buffer;
+    long long vertices = 0, normals = 0, textures = 0;
+    while (buffer.size() < size) {
+        auto line = std::to_string(mt() % 1000) + " " +
+                    std::to_string(mt() % 1000) + " " +
+                    std::to_string(mt() % 1000) + "\n";
+        switch (mt() % 5) {
+        case 0:
+            buffer += "v " + line;
+            vertices++;
+            break;
+        case 1:
+            buffer += "vn " + line;
+            normals++;
+            break;
+        case 2:
+            buffer += "vt " + line;
+            textures++;
+            break;
+        default:
+            if (vertices < 4 || normals < 4 || textures < 4)
+                break;
+            buffer += "f";
+            for (unsigned corner = 0; corner < 3 + mt() % 2; corner++) {
+                auto index = [&mt](long long count) {
+                    auto relative = static_cast<long long>(mt() % 4) + 1;
+                    return mt() % 2 ? count - relative + 1 : -relative;
+                };
+                buffer += " " + std::to_string(index(vertices)) + "/" +
+                          std::to_string(index(textures)) + "/" +
+                          std::to_string(index(normals));
+            }
+            buffer += "\n";
+        }
+    }
+    return buffer;
+}
+
+TEST_CASE("Parallel parsing gives the same result as sequential one")
+{
+    auto buffer = randomObj(6 * minChunkSize, 7);
+
+    auto parts = splitLines(buffer, 4);
+    CHECK(parts.size() == 4);
+    std::string joined;
+    for (auto part : parts) {
+        CHECK(part.ends_with('\n'));
+        joined += part;
+    }
+    CHECK(joined == buffer);
+
+    std::vector<Vertex> sequentialVertices, parallelVertices;
+    std::vector<Normal> sequentialNormals, parallelNormals;
+    std::vector<TextureCoord> sequentialTextures, parallelTextures;
+    std::vector<Face> sequentialPolygons, parallelPolygons;
+    parseBuffer(buffer, sequentialVertices, sequentialNormals,
+                sequentialTextures, sequentialPolygons);
+    par::WorkerPool pool{3};
+    parseBuffer(buffer, pool, parallelVertices, parallelNormals,
+                parallelTextures, parallelPolygons);
+
+    CHECK(parallelVertices == sequentialVertices);
+    CHECK(parallelNormals == sequentialNormals);
+    CHECK(parallelTextures == sequentialTextures);
+    REQUIRE(parallelPolygons.size() == sequentialPolygons.size());
+    bool same = true;
+    for (std::size_t i = 0; i < sequentialPolygons.size(); i++)
+        for (std::size_t corner = 0; corner < 3; corner++) {
+            auto a = sequentialPolygons[i][corner];
+            auto b = parallelPolygons[i][corner];
+            same = same && a.vertexOffset == b.vertexOffset &&
+                   a.normalOffset == b.normalOffset &&
+                   a.textureCoordinatesOffset == b.textureCoordinatesOffset;
+        }
+    CHECK(same);
+}
+
+TEST_CASE("Welding gives every distinct corner its own vertex")
+{
+    std::vector<Vertex> vertices{
+        {0, 0, 0, 1}, {1, 0, 0, 1}, {0, 1, 0, 1}, {1, 1, 0, 1}};
+    std::vector<Normal> normals{{0, 0, 1}, {0, 0, -1}};
+    std::vector<TextureCoord> textures{{0, 0, 0}, {1, 1, 0}};
+    auto corner = [](ssize_t vertex, ssize_t texture, ssize_t normal) {
+        return PolygonComponent{vertex, normal, texture};
+    };
+    std::vector<Face> faces{
+        {corner(0, 0, 0), corner(1, 1, 0), corner(2, 0, 0)},
+        // shares two corners with the first face, the third has other normal
+        {corner(2, 0, 0), corner(1, 1, 0), corner(3, 1, 1)},
+        // texture coordinate is absent
+        {corner(0, -1, 0), corner(3, 1, 1), corner(2, 0, 0)},
+        // position isn't in array, so face is skipped
+        {corner(0, 0, 0), corner(4, 0, 0), corner(2, 0, 0)}};
+
+    VertexWelder welder;
+    auto mesh = welder.weld(faces, vertices, normals, textures);
+    REQUIRE(mesh.triangles.size() == 3);
+    CHECK(mesh.vertices.size() == 5);
+    CHECK(mesh.normals.size() == 5);
+    CHECK(mesh.textureCoords.size() == 5);
+    CHECK((mesh.triangles[0] == Triangle{0, 1, 2}));
+    CHECK((mesh.triangles[1] == Triangle{2, 1, 3}));
+    CHECK((mesh.triangles[2] == Triangle{4, 3, 2}));
+    // every attribute of corner is at index of its vertex
+    for (std::size_t face = 0; face < 3; face++)
+        for (std::size_t k = 0; k < 3; k++) {
+            auto component = faces[face][k];
+            auto vertex = mesh.triangles[face][k];
+            CHECK(mesh.vertices[vertex] ==
+                  vertices[static_cast<std::size_t>(component.vertexOffset)]);
+            CHECK(mesh.normals[vertex] ==
+                  normals[static_cast<std::size_t>(component.normalOffset)]);
+            auto texture = component.textureCoordinatesOffset;
+            CHECK(mesh.textureCoords[vertex] ==
+                  (texture < 0 ? TextureCoord{}
+                               : textures[static_cast<std::size_t>(texture)]));
+        }
+
+    // next call reuses welded vertices and gives only new ones
+    auto next = welder.weld({{corner(3, 1, 1), corner(2, 0, 0),
+                              corner(1, 0, 0)}},
+                            vertices, normals, textures);
+    CHECK(next.vertices.size() == 1);
+    REQUIRE(next.triangles.size() == 1);
+    CHECK((next.triangles[0] == Triangle{3, 2, 5}));
+    CHECK(welder.size() == 6);
+
+    // model without normals has no normals after welding
+    auto withoutNormals = weld({{PolygonComponent{0}, PolygonComponent{1},
+                                 PolygonComponent{2}}},
+                               vertices, {}, {});
+    CHECK(withoutNormals.vertices.size() == 3);
+    CHECK(withoutNormals.normals.empty());
+    CHECK(withoutNormals.textureCoords.empty());
+}
+
+TEST_CASE("Streamed parts make the same model as parsed file")
+{
+    std::vector<Vertex> vertices;
+    std::vector<Normal> normals;
+    std::vector<TextureCoord> textures;
+    std::vector<Face> polygons;
+    auto buffer = randomObj(3 * streamPartSize + streamPartSize / 2, 11);
+    parseBuffer(buffer, vertices, normals, textures, polygons);
+    // the first face refers to the last elements, which are in the last
+    // part, so it's moved there
+    auto last = std::to_string(vertices.size()) + "/" +
+                std::to_string(textures.size()) + "/" +
+                std::to_string(normals.size());
+    buffer = "f " + last + " " + last + " 1/1/1\n" + buffer;
+    vertices.clear();
+    normals.clear();
+    textures.clear();
+    polygons.clear();
+    parseBuffer(buffer, vertices, normals, textures, polygons);
+    std::rotate(polygons.begin(), polygons.begin() + 1, polygons.end());
+    auto expected = weld(polygons, vertices, normals, textures);
+    auto path = temporaryPath("objparsertest_stream");
+    std::ofstream{path} << buffer;
+
+    std::size_t partsCount = 0;
+    bool refersBehind = true;
+    WeldedMesh streamed;
+    {
+        StreamingParser stream{path.string()};
+        while (!stream.finished()) {
+            for (auto &part : stream.takeParts()) {
+                partsCount++;
+                std::ranges::copy(part.vertices,
+                                  std::back_inserter(streamed.vertices));
+                std::ranges::copy(part.normals,
+                                  std::back_inserter(streamed.normals));
+                std::ranges::copy(part.textureCoords,
+                                  std::back_inserter(streamed.textureCoords));
+                for (const auto &triangle : part.triangles) {
+                    for (auto vertex : triangle)
+                        refersBehind = refersBehind &&
+                                       vertex < streamed.vertices.size();
+                    streamed.triangles.push_back(triangle);
+                }
+            }
+        }
+    }
+    std::filesystem::remove(path);
+
+    CHECK(partsCount == 3);
+    CHECK(refersBehind);
+    CHECK(streamed.vertices == expected.vertices);
+    CHECK(streamed.normals == expected.normals);
+    CHECK(streamed.textureCoords == expected.textureCoords);
+    CHECK(streamed.triangles == expected.triangles);
+
+    CHECK_THROWS_AS(StreamingParser{path.string()}, std::system_error);
+}
+
 TEST_CASE("Parse file completely")
 {
     std::ifstream file(parseFileTest_source);
@@ -101,7 +397,7 @@ TEST_CASE("Parse file completely")
     std::vector<Vertex> vertices;
     std::vector<Normal> normals;
     std::vector<TextureCoord> textures;
-    std::vector<Triangle> polygons;
+    std::vector<Face> polygons;
 
     parseStream(file, vertices, normals, textures, polygons);
 
@@ -0,0 +1,101 @@
+#include "WorkerPool.h"
+#include <utility>
+
+namespace eng::par {
+
+WorkerPool::WorkerPool(unsigned workersCount)
+    : _workers{}, _callMutex{}, _mutex{}, _wakeUp{}, _done{}, _task{nullptr},
+      _count{}, _next{}, _error{}, _generation{}, _busy{}, _stop{false}
+{
+    _workers.reserve(workersCount);
+    for (unsigned i = 0; i < workersCount; i++)
+        _workers.emplace_back([this] { workerLoop(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock{_mutex};
+        _stop = true;
+    }
+    _wakeUp.notify_all();
+    // workers must be joined while mutex and condition variables are alive
+    _workers.clear();
+}
+
+unsigned WorkerPool::size() const noexcept
+{
+    return static_cast<unsigned>(_workers.size()) + 1;
+}
+
+unsigned WorkerPool::defaultWorkersCount() noexcept
+{
+    auto hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void WorkerPool::parallelFor(std::size_t count,
+                             const std::function<void(std::size_t)> &task)
+{
+    if (count == 0)
+        return;
+    if (_workers.empty() || count == 1) {
+        for (std::size_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    std::lock_guard call{_callMutex};
+    {
+        std::lock_guard lock{_mutex};
+        _task = &task;
+        _count = count;
+        _next.store(0, std::memory_order_relaxed);
+        _error = nullptr;
+        _busy = static_cast<unsigned>(_workers.size());
+        _generation++;
+    }
+    _wakeUp.notify_all();
+    runTasks();
+
+    std::unique_lock lock{_mutex};
+    _done.wait(lock, [this] { return _busy == 0; });
+    _task = nullptr;
+    if (_error)
+        std::rethrow_exception(std::exchange(_error, nullptr));
+}
+
+void WorkerPool::workerLoop()
+{
+    for (uint64_t seenGeneration = 0;;) {
+        {
+            std::unique_lock lock{_mutex};
+            _wakeUp.wait(lock, [&] {
+                return _stop || _generation != seenGeneration;
+            });
+            if (_stop)
+                return;
+            seenGeneration = _generation;
+        }
+        runTasks();
+        std::lock_guard lock{_mutex};
+        if (--_busy == 0)
+            _done.notify_one();
+    }
+}
+
+void WorkerPool::runTasks()
+{
+    for (auto i = _next.fetch_add(1, std::memory_order_relaxed); i < _count;
+         i = _next.fetch_add(1, std::memory_order_relaxed)) {
+        try {
+            (*_task)(i);
+        } catch (...) {
+            std::lock_guard lock{_mutex};
+            if (!_error)
+                _error = std::current_exception();
+        }
+    }
+}
+
+} // namespace eng::par
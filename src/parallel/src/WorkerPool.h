@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eng::par {
+
+/*
+ * Fixed set of threads which are sleeping between parallelFor calls. Indexes
+ * are handed out one by one from shared counter, so threads which finished
+ * their part earlier take the rest of work from slower ones. Calling thread
+ * takes part in work too, so pool with zero workers is just sequential loop.
+ * parallelFor must not be called from inside of task of the same pool.
+ */
+class WorkerPool final {
+public:
+    explicit WorkerPool(unsigned workersCount = defaultWorkersCount());
+    ~WorkerPool();
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // threads count including calling one
+    [[nodiscard]] unsigned size() const noexcept;
+
+    // calls task(i) for every i in [0, count), returns when all calls are
+    // finished, first exception thrown by task is rethrown here
+    void parallelFor(std::size_t count,
+                     const std::function<void(std::size_t)> &task);
+
+    [[nodiscard]] static unsigned defaultWorkersCount() noexcept;
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::jthread> _workers;
+    std::mutex _callMutex;
+    std::mutex _mutex;
+    std::condition_variable _wakeUp;
+    std::condition_variable _done;
+    const std::function<void(std::size_t)> *_task;
+    std::size_t _count;
+    std::atomic<std::size_t> _next;
+    std::exception_ptr _error;
+    uint64_t _generation;
+    unsigned _busy;
+    bool _stop;
+};
+
+} // namespace eng::par
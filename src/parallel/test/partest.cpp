@@ -0,0 +1,52 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "../src/WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <doctest/doctest.h>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace eng::par;
+
+TEST_CASE("Every index is processed exactly once")
+{
+    WorkerPool pool{3};
+    CHECK(pool.size() == 4);
+    std::vector<int> hits(1000);
+    pool.parallelFor(hits.size(), [&hits](std::size_t i) { hits[i]++; });
+    CHECK(std::all_of(hits.begin(), hits.end(),
+                      [](int value) { return value == 1; }));
+}
+
+TEST_CASE("Pool is reusable between calls")
+{
+    WorkerPool pool{2};
+    std::atomic<std::size_t> sum{};
+    for (unsigned call = 0; call < 50; call++)
+        pool.parallelFor(100, [&sum](std::size_t i) { sum += i; });
+    CHECK(sum.load() == 50 * 4950);
+}
+
+TEST_CASE("Pool without workers runs in calling thread")
+{
+    WorkerPool pool{0};
+    CHECK(pool.size() == 1);
+    std::vector<std::size_t> order;
+    pool.parallelFor(5, [&order](std::size_t i) { order.push_back(i); });
+    std::vector<std::size_t> expected(5);
+    std::iota(expected.begin(), expected.end(), 0);
+    CHECK(order == expected);
+}
+
+TEST_CASE("Exception from task is passed to caller")
+{
+    WorkerPool pool{2};
+    CHECK_THROWS(pool.parallelFor(64, [](std::size_t i) {
+        if (i == 33)
+            throw std::runtime_error{"task failed"};
+    }));
+    std::atomic<unsigned> count{};
+    pool.parallelFor(64, [&count](std::size_t) { count++; });
+    CHECK(count.load() == 64);
+}
@@ -0,0 +1,230 @@
+#include "CoverageKernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ENG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace eng::pipe {
+
+namespace {
+
+constexpr auto laneCount = alg::rasterizationBlockSize;
+
+uint32_t coverRowScalar(const alg::TriangleEdges &triangle, uint32_t blockX,
+                        uint32_t y, uint32_t lanes, bool fullyCovered,
+                        floating *zRow, RowCoverage &coverage) noexcept
+{
+    auto [u, v, w] = triangle.edges;
+    auto xStart = static_cast<floating>(blockX);
+    auto yRow = static_cast<floating>(y);
+    auto uRow = u(xStart, yRow), vRow = v(xStart, yRow),
+         wRow = w(xStart, yRow), zStart = triangle.z(xStart, yRow);
+    uint32_t passed = 0;
+    for (uint32_t lane = 0; lane < laneCount; lane++) {
+        if ((lanes & (1u << lane)) == 0)
+            continue;
+        auto step = static_cast<floating>(lane);
+        auto uValue = uRow + step * u.dx, vValue = vRow + step * v.dx,
+             wValue = wRow + step * w.dx;
+        if (!fullyCovered &&
+            !(triangle.covers(0, uValue) && triangle.covers(1, vValue) &&
+              triangle.covers(2, wValue)))
+            continue;
+        auto z = zStart + step * triangle.z.dx;
+        if (!(z < zRow[lane]))
+            continue;
+        zRow[lane] = z;
+        coverage.u[lane] = uValue * triangle.inverseSquare2x;
+        coverage.v[lane] = vValue * triangle.inverseSquare2x;
+        coverage.w[lane] = wValue * triangle.inverseSquare2x;
+        passed |= 1u << lane;
+    }
+    return passed;
+}
+
+#ifdef ENG_X86_KERNELS
+
+static_assert(laneCount == 8, "vector kernels process row of 8 pixels");
+
+/*
+ * Lane values are computed as row start + lane * dx, the same operations as
+ * scalar kernel does, and without fused multiply-add, so results are equal
+ * bit by bit. Coverage test value > 0 || (value == 0 && inclusive) is the
+ * same as value >= 0 for inclusive edge.
+ */
+
+__attribute__((target("sse2"))) __m128
+laneValuesSSE(floating start, floating step, floating firstLane) noexcept
+{
+    auto laneIndex =
+        _mm_add_ps(_mm_set1_ps(firstLane), _mm_setr_ps(0, 1, 2, 3));
+    return _mm_add_ps(_mm_set1_ps(start),
+                      _mm_mul_ps(laneIndex, _mm_set1_ps(step)));
+}
+
+__attribute__((target("sse2"))) __m128
+coveredSSE(__m128 value, bool inclusive) noexcept
+{
+    return inclusive ? _mm_cmpge_ps(value, _mm_setzero_ps())
+                     : _mm_cmpgt_ps(value, _mm_setzero_ps());
+}
+
+// values of edges and z in the first pixel of row
+struct RowStart {
+    floating u, v, w, z;
+};
+
+// SSE kernel processes row as two halves of 4 lanes
+__attribute__((target("sse2"))) uint32_t
+coverHalfSSE(const alg::TriangleEdges &triangle, RowStart start,
+             uint32_t firstLane, uint32_t lanes, bool fullyCovered,
+             floating *zRow, RowCoverage &coverage) noexcept
+{
+    const auto laneBits = _mm_setr_epi32(1, 2, 4, 8);
+    auto [uEdge, vEdge, wEdge] = triangle.edges;
+    auto first = static_cast<floating>(firstLane);
+    auto uValues = laneValuesSSE(start.u, uEdge.dx, first);
+    auto vValues = laneValuesSSE(start.v, vEdge.dx, first);
+    auto wValues = laneValuesSSE(start.w, wEdge.dx, first);
+    auto bits = _mm_and_si128(
+        _mm_set1_epi32(static_cast<int>(lanes >> firstLane)), laneBits);
+    auto mask = _mm_castsi128_ps(_mm_cmpeq_epi32(bits, laneBits));
+    if (!fullyCovered)
+        mask = _mm_and_ps(
+            _mm_and_ps(mask, coveredSSE(uValues, triangle.inclusive[0])),
+            _mm_and_ps(coveredSSE(vValues, triangle.inclusive[1]),
+                       coveredSSE(wValues, triangle.inclusive[2])));
+    auto z = laneValuesSSE(start.z, triangle.z.dx, first);
+    auto old = _mm_loadu_ps(zRow + firstLane);
+    mask = _mm_and_ps(mask, _mm_cmplt_ps(z, old));
+    auto passed = static_cast<uint32_t>(_mm_movemask_ps(mask));
+    if (passed == 0)
+        return 0;
+    _mm_storeu_ps(zRow + firstLane,
+                  _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, old)));
+    auto scale = _mm_set1_ps(triangle.inverseSquare2x);
+    _mm_storeu_ps(coverage.u.data() + firstLane, _mm_mul_ps(uValues, scale));
+    _mm_storeu_ps(coverage.v.data() + firstLane, _mm_mul_ps(vValues, scale));
+    _mm_storeu_ps(coverage.w.data() + firstLane, _mm_mul_ps(wValues, scale));
+    return passed << firstLane;
+}
+
+__attribute__((target("sse2"))) uint32_t
+coverRowSSE(const alg::TriangleEdges &triangle, uint32_t blockX, uint32_t y,
+            uint32_t lanes, bool fullyCovered, floating *zRow,
+            RowCoverage &coverage) noexcept
+{
+    auto xStart = static_cast<floating>(blockX);
+    auto yRow = static_cast<floating>(y);
+    auto [u, v, w] = triangle.edges;
+    RowStart start{u(xStart, yRow), v(xStart, yRow), w(xStart, yRow),
+                   triangle.z(xStart, yRow)};
+    uint32_t passed = 0;
+    if ((lanes & 0xfu) != 0)
+        passed = coverHalfSSE(triangle, start, 0, lanes, fullyCovered, zRow,
+                              coverage);
+    if ((lanes >> 4) != 0)
+        passed |= coverHalfSSE(triangle, start, 4, lanes, fullyCovered, zRow,
+                               coverage);
+    return passed;
+}
+
+__attribute__((target("avx2"))) __m256 laneValuesAVX2(floating start,
+                                                       floating step) noexcept
+{
+    return _mm256_add_ps(
+        _mm256_set1_ps(start),
+        _mm256_mul_ps(_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7),
+                      _mm256_set1_ps(step)));
+}
+
+__attribute__((target("avx2"))) __m256
+coveredAVX2(__m256 value, bool inclusive) noexcept
+{
+    return inclusive ? _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GE_OQ)
+                     : _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GT_OQ);
+}
+
+__attribute__((target("avx2"))) uint32_t
+coverRowAVX2(const alg::TriangleEdges &triangle, uint32_t blockX, uint32_t y,
+             uint32_t lanes, bool fullyCovered, floating *zRow,
+             RowCoverage &coverage) noexcept
+{
+    const auto laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    auto xStart = static_cast<floating>(blockX);
+    auto yRow = static_cast<floating>(y);
+    auto [uEdge, vEdge, wEdge] = triangle.edges;
+    auto uValues = laneValuesAVX2(uEdge(xStart, yRow), uEdge.dx);
+    auto vValues = laneValuesAVX2(vEdge(xStart, yRow), vEdge.dx);
+    auto wValues = laneValuesAVX2(wEdge(xStart, yRow), wEdge.dx);
+    auto bits = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(lanes)),
+                                 laneBits);
+    auto mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(bits, laneBits));
+    if (!fullyCovered)
+        mask = _mm256_and_ps(
+            _mm256_and_ps(mask, coveredAVX2(uValues, triangle.inclusive[0])),
+            _mm256_and_ps(coveredAVX2(vValues, triangle.inclusive[1]),
+                          coveredAVX2(wValues, triangle.inclusive[2])));
+    auto z = laneValuesAVX2(triangle.z(xStart, yRow), triangle.z.dx);
+    auto old = _mm256_loadu_ps(zRow);
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(z, old, _CMP_LT_OQ));
+    auto passed = static_cast<uint32_t>(_mm256_movemask_ps(mask));
+    if (passed == 0)
+        return 0;
+    _mm256_storeu_ps(zRow, _mm256_blendv_ps(old, z, mask));
+    auto scale = _mm256_set1_ps(triangle.inverseSquare2x);
+    _mm256_storeu_ps(coverage.u.data(), _mm256_mul_ps(uValues, scale));
+    _mm256_storeu_ps(coverage.v.data(), _mm256_mul_ps(vValues, scale));
+    _mm256_storeu_ps(coverage.w.data(), _mm256_mul_ps(wValues, scale));
+    return passed;
+}
+
+#endif
+
+} // namespace
+
+bool isSupported(CoverageKernel kernel) noexcept
+{
+    switch (kernel) {
+    case CoverageKernel::Scalar:
+        return true;
+#ifdef ENG_X86_KERNELS
+    case CoverageKernel::SSE:
+        return __builtin_cpu_supports("sse2");
+    case CoverageKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+CoverageKernel bestCoverageKernel() noexcept
+{
+    static const auto best = [] {
+        for (auto kernel : {CoverageKernel::AVX2, CoverageKernel::SSE})
+            if (isSupported(kernel))
+                return kernel;
+        return CoverageKernel::Scalar;
+    }();
+    return best;
+}
+
+CoverRow coverRowFunction(CoverageKernel kernel) noexcept
+{
+    if (!isSupported(kernel))
+        return coverRowScalar;
+    switch (kernel) {
+#ifdef ENG_X86_KERNELS
+    case CoverageKernel::SSE:
+        return coverRowSSE;
+    case CoverageKernel::AVX2:
+        return coverRowAVX2;
+#endif
+    default:
+        return coverRowScalar;
+    }
+}
+
+} // namespace eng::pipe
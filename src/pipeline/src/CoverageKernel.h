@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../../algorithm/src/alg.h"
+#include <array>
+#include <cstdint>
+
+namespace eng::pipe {
+
+// barycentric coordinates of row of rasterization block, lane i is pixel
+// blockX + i
+struct RowCoverage {
+    std::array<floating, alg::rasterizationBlockSize> u, v, w;
+};
+
+/*
+ * Tests coverage of row of aligned block and depth of covered pixels against
+ * zRow, z-buffer value of pixel blockX. All rasterizationBlockSize values
+ * after zRow must be readable and writable by calling thread: vector kernels
+ * load and store them whole and keep values of lanes which are not tested.
+ * Only lanes set in lanes mask are tested, depth of passed ones is written.
+ * Returns mask of passed lanes, their coordinates are stored in coverage.
+ */
+using CoverRow = uint32_t (*)(const alg::TriangleEdges &triangle,
+                              uint32_t blockX, uint32_t y, uint32_t lanes,
+                              bool fullyCovered, floating *zRow,
+                              RowCoverage &coverage) noexcept;
+
+// all kernels give bitwise equal results, they differ only in speed
+enum class CoverageKernel { Scalar, SSE, AVX2 };
+
+[[nodiscard]] bool isSupported(CoverageKernel kernel) noexcept;
+// the widest kernel which processor supports
+[[nodiscard]] CoverageKernel bestCoverageKernel() noexcept;
+// scalar kernel is returned for unsupported one
+[[nodiscard]] CoverRow coverRowFunction(CoverageKernel kernel) noexcept;
+
+} // namespace eng::pipe
@@ -0,0 +1,74 @@
+#include "DepthBuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace eng::pipe {
+
+void DepthBuffer::resize(uint32_t bufferSize, uint32_t xSize)
+{
+    constexpr auto blockSize = alg::rasterizationBlockSize;
+    _xSize = xSize;
+    _stride = (xSize + blockSize - 1) & ~(blockSize - 1);
+    auto rowsCount = xSize == 0 ? 0 : bufferSize / xSize;
+    _depth.resize(std::size_t{rowsCount} * _stride);
+    auto blockRows = (rowsCount + blockSize - 1) / blockSize;
+    _blockMax.resize(std::size_t{blockRows} * _stride / blockSize);
+}
+
+void DepthBuffer::clear() noexcept
+{
+    std::fill(_depth.begin(), _depth.end(), 1);
+    std::fill(_blockMax.begin(), _blockMax.end(), 1);
+}
+
+void DepthBuffer::clear(alg::PixelRect region) noexcept
+{
+    constexpr auto blockSize = alg::rasterizationBlockSize;
+    for (auto y = region.yMin; y <= region.yMax; y++) {
+        auto row = _depth.begin() +
+                   static_cast<std::ptrdiff_t>(y * _stride + region.xMin);
+        std::fill(row, row + (region.xMax - region.xMin + 1), 1);
+    }
+    for (auto y = region.yMin; y <= region.yMax; y += blockSize) {
+        auto row = _blockMax.begin() +
+                   static_cast<std::ptrdiff_t>(blockIndex(region.xMin, y));
+        std::fill(row, row + (region.xMax - region.xMin) / blockSize + 1, 1);
+    }
+}
+
+bool DepthBuffer::isBlockOccluded(const alg::TriangleEdges &triangle,
+                                  floating nearestZ,
+                                  alg::PixelRect block) const noexcept
+{
+    auto x = static_cast<floating>(block.xMin);
+    auto y = static_cast<floating>(block.yMin);
+    auto width = static_cast<floating>(block.xMax - block.xMin);
+    auto height = static_cast<floating>(block.yMax - block.yMin);
+    const auto &z = triangle.z;
+    auto planeMin = z(x, y) + std::min(z.dx * width, floating{0}) +
+                    std::min(z.dy * height, floating{0});
+    // depth of pixel is computed in other order and may be a bit nearer
+    auto tolerance = 32 * std::numeric_limits<floating>::epsilon() *
+                     (std::abs(z.dx) * (x + width) +
+                      std::abs(z.dy) * (y + height) + std::abs(z.c) + 1);
+    return std::max(planeMin, nearestZ) - tolerance >=
+           _blockMax[blockIndex(block.xMin, block.yMin)];
+}
+
+void DepthBuffer::updateBlockDepth(uint32_t blockX, uint32_t blockY) noexcept
+{
+    constexpr auto blockSize = alg::rasterizationBlockSize;
+    blockY &= ~(blockSize - 1);
+    auto width = std::min(blockSize, _xSize - blockX);
+    auto height = std::min(blockSize, rows() - blockY);
+    floating depth = 0;
+    for (auto y = blockY; y < blockY + height; y++) {
+        auto row = _depth.cbegin() +
+                   static_cast<std::ptrdiff_t>(y * _stride + blockX);
+        depth = std::max(depth, *std::max_element(row, row + width));
+    }
+    _blockMax[blockIndex(blockX, blockY)] = depth;
+}
+
+} // namespace eng::pipe
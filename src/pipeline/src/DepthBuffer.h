@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../../algorithm/src/alg.h"
+#include <cstdint>
+#include <vector>
+
+namespace eng::pipe {
+
+/*
+ * Z-buffer with upper bound of depth of every aligned rasterization block,
+ * block in which triangle can't be nearer than its bound is skipped before
+ * coverage kernel and shader. Bound is recomputed from block pixels after
+ * writes. Rows are padded to whole blocks, so coverage kernel can load and
+ * store row of block without going out of row.
+ */
+class DepthBuffer final {
+public:
+    // rows of xSize pixels which fit in bufferSize
+    void resize(uint32_t bufferSize, uint32_t xSize);
+
+    [[nodiscard]] uint32_t xSize() const noexcept { return _xSize; }
+    [[nodiscard]] uint32_t rows() const noexcept
+    {
+        return _stride == 0 ? 0
+                            : static_cast<uint32_t>(_depth.size() / _stride);
+    }
+
+    [[nodiscard]] floating *row(uint32_t y) noexcept
+    {
+        return _depth.data() + std::size_t{y} * _stride;
+    }
+
+    void clear() noexcept;
+    // region is aligned to blocks
+    void clear(alg::PixelRect region) noexcept;
+
+    [[nodiscard]] bool isBlockOccluded(const alg::TriangleEdges &triangle,
+                                       floating nearestZ,
+                                       alg::PixelRect block) const noexcept;
+    void updateBlockDepth(uint32_t blockX, uint32_t blockY) noexcept;
+
+private:
+    [[nodiscard]] std::size_t blockIndex(uint32_t x,
+                                         uint32_t y) const noexcept
+    {
+        constexpr auto blockSize = alg::rasterizationBlockSize;
+        return std::size_t{y / blockSize} * (_stride / blockSize) +
+               x / blockSize;
+    }
+
+    std::vector<floating> _depth;
+    std::vector<floating> _blockMax;
+    uint32_t _xSize{}, _stride{};
+};
+
+} // namespace eng::pipe
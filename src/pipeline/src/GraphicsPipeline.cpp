@@ -5,8 +5,11 @@ namespace eng::pipe {
 
 GraphicsPipeline::GraphicsPipeline(ent::Model &model, ent::Camera &camera,
                                    ent::CameraProjection &projection)
-    : _model(model), _camera(camera), _projection(projection), _zBuffer{},
-      _xSize{}, _projectionType{ent::ProjectionType::Perspective}
+    : _model(model), _camera(camera), _projection(projection), _depth{},
+      _projectionType{ent::ProjectionType::Perspective},
+      _rasterizationMode{RasterizationMode::Binned}, _workers{}, _bins{},
+      _coverRow{coverRowFunction(bestCoverageKernel())},
+      _transform{transformFunction(bestTransformKernel())}, _frame{}
 {}
 
 [[nodiscard]] vec::Vec4F GraphicsPipeline::applyVertexTransformationFromWorldSpace(int minX, int maxX, int minY, int maxY, vec::Vec4F vertex){
@@ -28,11 +31,28 @@ GraphicsPipeline::GraphicsPipeline(ent::Model &model, ent::Camera &camera,
     }
     return vertex;
 }
-[[nodiscard]] std::vector<Vertex>
+void GraphicsPipeline::cullLights(int minX, int maxX, int minY, int maxY,
+                                  const ent::LightArray &lights,
+                                  LightTiles &tiles) const
+{
+    auto toScreen =
+        mtr::Matrix::getViewport(
+            static_cast<floating>(minX), static_cast<floating>(maxX),
+            static_cast<floating>(minY), static_cast<floating>(maxY)) *
+        _projection.getProjectionMatrix(_projectionType) *
+        _camera.getViewMatrix();
+    // tiles are indexed by pixel coordinates, not by ones inside of region
+    tiles.build(lights, toScreen, static_cast<uint32_t>(maxX),
+                static_cast<uint32_t>(maxY));
+}
+
+[[nodiscard]] const FrameVertices &
 GraphicsPipeline::applyVertexTransformations(int minX, int maxX, int minY,
-                                             int maxY) const noexcept
+                                             int maxY)
 {
-    std::vector<Vertex> copy{_model.verticesBegin(), _model.verticesEnd()};
+    const auto &positions = _model.getPositions();
+    _frame.screen.resize(positions.x.size());
+    _frame.outside.resize(positions.x.size());
     auto transformationMatrix =
         mtr::Matrix::getViewport(
             static_cast<floating>(minX), static_cast<floating>(maxX),
@@ -40,36 +60,43 @@ GraphicsPipeline::applyVertexTransformations(int minX, int maxX, int minY,
         _projection.getProjectionMatrix(_projectionType) *
         _camera.getViewMatrix() * _model.getModelMatrix();
 
-    auto transformVertex = [=,
-                            projection = this->_projectionType](auto &&vertex) {
-        vertex = transformationMatrix * vertex;
-        if (projection == eng::ent::ProjectionType::Perspective) {
-            std::transform(vertex.begin(), vertex.end() - 1, vertex.begin(),
-                           [w = *vertex.rbegin()](auto &&coord) {
-                               // if you brave enough, you can erase branch here
-                               // and leave coord /= w, but zero division is
-                               // undefined behaviour, remember
-                               return w > 0 ? coord /= w : coord;
-                           });
-        }
-
-        auto x = vertex.begin();
-        auto y = vertex.begin() + 1;
-        *x = std::clamp(*x, static_cast<floating>(minX),
-                        static_cast<floating>(maxX));
-        *y = std::clamp(*y, static_cast<floating>(minY),
-                        static_cast<floating>(maxY));
-
-        return vertex;
-    };
-    std::transform(copy.begin(), copy.end(), copy.begin(), transformVertex);
-    return copy;
+    std::vector<IndexRange> ranges;
+    for (auto [chunk, testFacing] : visibleChunks())
+        ranges.emplace_back(chunk->firstVertex, chunk->lastVertex);
+    std::sort(ranges.begin(), ranges.end());
+    // overlapping ranges are merged and split on batches for workers
+    std::vector<IndexRange> batches;
+    std::size_t transformed = 0;
+    for (auto [first, last] : ranges) {
+        for (first = std::max(first, transformed); first < last;
+             first += transformBatchSize)
+            batches.emplace_back(first,
+                                 std::min(first + transformBatchSize, last));
+        transformed = std::max(transformed, last);
+    }
+    _workers.parallelFor(
+        batches.size(),
+        [&, perspective = _projectionType == ent::ProjectionType::Perspective,
+         &matrix = transformationMatrix.getRepresentation(),
+         planes = guardBandPlanes()](std::size_t batch) {
+            auto [first, last] = batches[batch];
+            _transform(matrix, perspective, positions, first, last,
+                       _frame.screen.data());
+            for (auto i = first; i < last; i++) {
+                auto homogeneous = toHomogeneous(_frame.screen[i]);
+                uint8_t outside = 0;
+                for (std::size_t plane = 0; plane < planes.size(); plane++)
+                    if (planes[plane] * homogeneous < 0)
+                        outside |= static_cast<uint8_t>(1u << plane);
+                _frame.outside[i] = outside;
+            }
+        });
+    return _frame;
 }
 
 void GraphicsPipeline::setZBufferSize(uint32_t bufferSize, uint32_t xSize)
 {
-    _zBuffer.resize(bufferSize);
-    _xSize = xSize;
+    _depth.resize(bufferSize, xSize);
 }
 
 [[nodiscard]] ent::ProjectionType
@@ -83,4 +110,156 @@ void GraphicsPipeline::setProjectionType(
 {
     _projectionType = newProjectionType;
 }
-} // namespace eng::pipe
\ No newline at end of file
+
+[[nodiscard]] RasterizationMode
+GraphicsPipeline::getRasterizationMode() const noexcept
+{
+    return _rasterizationMode;
+}
+
+void GraphicsPipeline::setRasterizationMode(RasterizationMode newMode) noexcept
+{
+    _rasterizationMode = newMode;
+}
+
+[[nodiscard]] bool
+GraphicsPipeline::isFrontFacing(const Triangle &triangle,
+                                std::vector<Vertex>::const_iterator world,
+                                vec::Vec3F cameraEye) noexcept
+{
+    auto aInWorldSpace = (world + triangle[0])->trim<3>();
+    auto bInWorldSpace = (world + triangle[1])->trim<3>();
+    auto cInWorldSpace = (world + triangle[2])->trim<3>();
+    auto tNormal = vec::cross(cInWorldSpace - aInWorldSpace,
+                              bInWorldSpace - aInWorldSpace);
+    auto eyeDirection = aInWorldSpace - cameraEye;
+    return eyeDirection * tNormal >= 0;
+}
+
+vec::Vec4F GraphicsPipeline::toHomogeneous(Vertex vertex) noexcept
+{
+    auto w = vertex[3];
+    if (!(w > 0))
+        return vertex;
+    return {vertex[0] * w, vertex[1] * w, vertex[2] * w, w};
+}
+
+GraphicsPipeline::ClipPlanes
+GraphicsPipeline::clipPlanes(floating xMin, floating xMax, floating yMin,
+                             floating yMax) noexcept
+{
+    // depth of projection is in [0, w], viewport doesn't change it
+    return {vec::Vec4F{0, 0, 1, 0}, vec::Vec4F{0, 0, -1, 1},
+            vec::Vec4F{1, 0, 0, -xMin}, vec::Vec4F{-1, 0, 0, xMax},
+            vec::Vec4F{0, 1, 0, -yMin}, vec::Vec4F{0, -1, 0, yMax}};
+}
+
+GraphicsPipeline::ClipPlanes GraphicsPipeline::guardBandPlanes() const noexcept
+{
+    auto width = static_cast<floating>(_depth.xSize());
+    auto height = static_cast<floating>(_depth.rows());
+    return clipPlanes(-width, 2 * width, -height, 2 * height);
+}
+
+GraphicsPipeline::Facing
+GraphicsPipeline::chunkFacing(const ent::Model::Chunk &chunk, vec::Vec3F eye,
+                              floating orientation) noexcept
+{
+    if (!(chunk.coneCos > 0))
+        return Facing::Mixed;
+    /*
+     * Triangle is front facing if (a - eye) * normal >= 0. Over all points
+     * of bounding sphere and normals of cone (eye - p) * normal is in
+     * toEye * axis * cos -+ |toEye x axis| * sin -+ radius.
+     */
+    auto axis = chunk.coneAxis * orientation;
+    auto toEye = eye - chunk.center;
+    auto along = toEye * axis * chunk.coneCos;
+    auto across = vec::cross(toEye, axis).length() * chunk.coneSin;
+    if (along - across > chunk.radius)
+        return Facing::Back;
+    if (along + across + chunk.radius < 0)
+        return Facing::Front;
+    return Facing::Mixed;
+}
+
+std::vector<GraphicsPipeline::VisibleChunk>
+GraphicsPipeline::visibleChunks() const
+{
+    auto modelMatrix = _model.getModelMatrix();
+    // plane p of clip space is p * M in space which M transforms to clip one
+    auto toModelSpace = (_projection.getProjectionMatrix(_projectionType) *
+                         _camera.getViewMatrix() * modelMatrix)
+                            .getTransposed();
+    ClipPlanes frustum{vec::Vec4F{0, 0, 1, 0}, vec::Vec4F{0, 0, -1, 1},
+                       vec::Vec4F{1, 0, 0, 1}, vec::Vec4F{-1, 0, 0, 1},
+                       vec::Vec4F{0, 1, 0, 1}, vec::Vec4F{0, -1, 0, 1}};
+    for (auto &plane : frustum)
+        plane = toModelSpace * plane;
+
+    // singular model matrix leaves facing test to triangles
+    auto inverse = modelMatrix.getInverse();
+    vec::Vec3F eye{};
+    floating orientation = 0;
+    if (inverse) {
+        auto cameraEye = _camera.getEye();
+        eye = (*inverse * vec::Vec4F{cameraEye[0], cameraEye[1],
+                                     cameraEye[2], 1})
+                  .trim<3>();
+        auto axis = [&modelMatrix](vec::Vec4F direction) {
+            return (modelMatrix * direction).trim<3>();
+        };
+        auto determinant = vec::cross(axis({1, 0, 0, 0}), axis({0, 1, 0, 0})) *
+                           axis({0, 0, 1, 0});
+        orientation = determinant < 0 ? -1.0f : 1.0f;
+    }
+
+    std::vector<VisibleChunk> visible;
+    for (const auto &chunk : _model.getChunks()) {
+        if (alg::isBoxOutside(chunk.box, frustum))
+            continue;
+        auto facing =
+            inverse ? chunkFacing(chunk, eye, orientation) : Facing::Mixed;
+        if (facing != Facing::Back)
+            visible.push_back({&chunk, facing == Facing::Mixed});
+    }
+    return visible;
+}
+
+std::vector<GraphicsPipeline::TriangleRange>
+GraphicsPipeline::visibleTriangles() const
+{
+    std::vector<TriangleRange> ranges;
+    for (auto [chunk, testFacing] : visibleChunks()) {
+        if (!ranges.empty() && ranges.back().last == chunk->firstTriangle &&
+            ranges.back().testFacing == testFacing)
+            ranges.back().last = chunk->lastTriangle;
+        else
+            ranges.push_back(
+                {chunk->firstTriangle, chunk->lastTriangle, testFacing});
+    }
+    return ranges;
+}
+
+PixelPacket GraphicsPipeline::packetOf(uint32_t blockX, uint32_t y,
+                                       uint32_t passed,
+                                       const RowCoverage &coverage,
+                                       const Triangle &triangle,
+                                       const BarycentricMap *map) noexcept
+{
+    PixelPacket packet{blockX,     y,          passed, coverage.u,
+                       coverage.v, coverage.w, triangle};
+    if (!map)
+        return packet;
+    for (; passed != 0; passed &= passed - 1) {
+        auto lane = static_cast<std::size_t>(std::countr_zero(passed));
+        auto source = (*map)[0] * packet.u[lane] + (*map)[1] * packet.v[lane] +
+                      (*map)[2] * packet.w[lane];
+        packet.u[lane] = source[0];
+        packet.v[lane] = source[1];
+        packet.w[lane] = source[2];
+    }
+    return packet;
+}
+
+} // namespace eng::pipe
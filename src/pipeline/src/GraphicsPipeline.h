@@ -1,9 +1,17 @@
 #pragma once
 
 #include "../../algorithm/src/alg.h"
+#include "../../entities/src/Buffers.h"
 #include "../../entities/src/Camera.h"
 #include "../../entities/src/CameraProjection.h"
 #include "../../entities/src/Model.h"
+#include "../../parallel/src/WorkerPool.h"
+#include "CoverageKernel.h"
+#include "DepthBuffer.h"
+#include "LightTiles.h"
+#include "TransformKernel.h"
+#include <bit>
+#include <concepts>
 
 namespace eng::pipe {
 
@@ -15,103 +23,505 @@ concept Shader = requires(T &&shader, uint32_t x, uint32_t y, floating u,
     } -> std::same_as<void>;
 };
 
+// shader which takes covered pixels of row of rasterization block at once,
+// it's preferred to per pixel one if shader is both
+template <typename T>
+concept PacketShader = requires(T &&shader, const PixelPacket &packet) {
+    {
+        shader(packet)
+    } -> std::same_as<void>;
+};
+
+// shader which takes index of triangle in model instead of triangle and
+// only u and v, w is 1 - u - v
+template <typename T>
+concept TriangleIndexShader =
+    requires(T &&shader, uint32_t x, uint32_t y, floating u, floating v,
+             uint32_t triangleIndex) {
+        {
+            shader(x, y, u, v, triangleIndex)
+        } -> std::same_as<void>;
+    };
+
+template <typename T>
+concept AnyShader = Shader<T> || PacketShader<T> || TriangleIndexShader<T>;
+
+/*
+ * Sequential mode walks triangles in model order on calling thread. Binned
+ * mode sets triangles up in parallel, sorts them into screen tiles and then
+ * every tile is rasterized by one thread, so tile is the only writer of its
+ * part of z-buffer and of shader output. Shader is copied for every tile.
+ */
+enum class RasterizationMode { Sequential, Binned };
+
+/*
+ * Vertices of model after transformation of one frame. Every vertex is
+ * transformed once and shared by all triangles and shaders which refer to
+ * it, vertices used by no visible triangle are not written.
+ */
+struct FrameVertices {
+    // viewport space, x, y and z are divided by w if w > 0, w is clip one
+    std::vector<Vertex> screen;
+    // bit i is set if vertex is outside of i-th plane of guard band for
+    // z-buffer size at time of transformation
+    std::vector<uint8_t> outside;
+};
+
 class GraphicsPipeline final {
 public:
     GraphicsPipeline(ent::Model &model, ent::Camera &camera,
                      ent::CameraProjection &projection);
     [[nodiscard]] vec::Vec4F applyVertexTransformationFromWorldSpace(int minX, int maxX, int minY, int maxY, vec::Vec4F vertex);
-    [[nodiscard]] std::vector<Vertex>
-    applyVertexTransformations(int minX, int maxX, int minY,
-                               int maxY) const noexcept;
+    // vertices of visible chunks are transformed by batches in parallel,
+    // buffer is reused by next call
+    [[nodiscard]] const FrameVertices &
+    applyVertexTransformations(int minX, int maxX, int minY, int maxY);
+
+    // point lights of every tile of region for current camera and projection
+    void cullLights(int minX, int maxX, int minY, int maxY,
+                    const ent::LightArray &lights, LightTiles &tiles) const;
 
     [[nodiscard]] ent::ProjectionType getProjectionType() const noexcept;
     void setProjectionType(ent::ProjectionType newProjectionType) noexcept;
 
+    [[nodiscard]] RasterizationMode getRasterizationMode() const noexcept;
+    void setRasterizationMode(RasterizationMode newMode) noexcept;
+
     void setZBufferSize(uint32_t bufferSize, uint32_t xSize);
 
     template <typename Out>
     void drawMesh(int minX, int maxX, int minY, int maxY, Out out)
     {
-        auto verticesCopy = applyVertexTransformations(minX, maxX, minY, maxY);
-        auto copyIterator = verticesCopy.cbegin();
-        std::for_each(
-            _model.trianglesBegin(), _model.trianglesEnd(),
-            [=, cameraEye = _camera.getEye()](auto &&polygon) mutable {
-                auto a = (copyIterator + polygon[0].vertexOffset)
-                             ->template trim<3>();
-                auto b = (copyIterator + polygon[1].vertexOffset)
-                             ->template trim<3>();
-                auto c = (copyIterator + polygon[2].vertexOffset)
-                             ->template trim<3>();
-
-                auto triangleNormal = vec::cross(c - a, b - a);
-                auto eyeDirection = a - cameraEye;
-                auto normalProduct = eyeDirection * triangleNormal;
-
-                if (normalProduct >= 0) {
-                    alg::drawTriangle(a.template convert<2, integral>(),
-                                      b.template convert<2, integral>(),
-                                      c.template convert<2, integral>(), out);
+        const auto &frame = applyVertexTransformations(minX, maxX, minY, maxY);
+        auto copyIterator = frame.screen.cbegin();
+        // lines are clipped by the last pixels, not by viewport borders
+        auto planes = clipPlanes(static_cast<floating>(minX),
+                                 static_cast<floating>(maxX - 1),
+                                 static_cast<floating>(minY),
+                                 static_cast<floating>(maxY - 1));
+        auto drawTriangle =
+            [=, world = _model.getWorldVertices().cbegin(),
+             cEye = _camera.getEye()](const Triangle &polygon,
+                                      bool testFacing) mutable {
+                if (!testFacing || isFrontFacing(polygon, world, cEye)) {
+                    auto clipped = alg::clipTriangle(
+                        std::array<vec::Vec4F, 3>{
+                            toHomogeneous(*(copyIterator + polygon[0])),
+                            toHomogeneous(*(copyIterator + polygon[1])),
+                            toHomogeneous(*(copyIterator + polygon[2]))},
+                        planes);
+                    for (std::size_t i = 0; i < clipped.size; i++) {
+                        auto from = clipped.vertices[i].position;
+                        auto to =
+                            clipped.vertices[(i + 1) % clipped.size].position;
+                        alg::line(static_cast<integral>(from[0] / from[3]),
+                                  static_cast<integral>(to[0] / to[3]),
+                                  static_cast<integral>(from[1] / from[3]),
+                                  static_cast<integral>(to[1] / to[3]), out);
+                    }
+                }
+            };
+        for (const auto &range : visibleTriangles())
+            for (auto i = range.first; i < range.last; i++)
+                drawTriangle(
+                    _model.trianglesBegin()[static_cast<std::ptrdiff_t>(i)],
+                    range.testFacing);
+    }
+
+    template <AnyShader ShaderCallable>
+        requires std::copy_constructible<std::decay_t<ShaderCallable>>
+    void rasterize(const FrameVertices &frame, ShaderCallable &&shader)
+    {
+        if (_rasterizationMode == RasterizationMode::Binned)
+            rasterizeBinned(frame, shader);
+        else
+            rasterizeSequential(frame, shader);
+    }
+
+    /*
+     * Shades every pixel of visibility buffer which has triangle by
+     * shader(x, y, u, v, w, triangle) and passes color to out(x, y, color).
+     * Bands of rows are resolved in parallel, every band by its own copy of
+     * shader, so out is called for different pixels concurrently.
+     */
+    template <typename ShaderCallable, typename Out>
+        requires std::copy_constructible<ShaderCallable>
+    void resolve(const ent::VisibilityBuffer &visibility,
+                 const ShaderCallable &shader, const Out &out)
+    {
+        auto xSize = std::size_t{visibility.xSize()};
+        if (xSize == 0)
+            return;
+        auto rows = visibility.size() / xSize;
+        auto bands = (rows + resolveBandRows - 1) / resolveBandRows;
+        auto triangles = _model.trianglesBegin();
+        _workers.parallelFor(bands, [&](std::size_t band) {
+            auto bandShader = shader;
+            auto first = band * resolveBandRows * xSize;
+            auto last =
+                std::min(first + resolveBandRows * xSize, rows * xSize);
+            visibility.forEachVisible(
+                first, last,
+                [&](std::size_t pixel, floating u, floating v, floating w,
+                    uint32_t triangle) {
+                    auto x = static_cast<uint32_t>(pixel % xSize);
+                    auto y = static_cast<uint32_t>(pixel / xSize);
+                    out(x, y,
+                        bandShader(
+                            x, y, u, v, w,
+                            triangles[static_cast<std::ptrdiff_t>(triangle)]));
+                });
+        });
+    }
+
+private:
+    static constexpr uint32_t binnedTileSize = 64;
+    static constexpr std::size_t resolveBandRows = 8;
+    static constexpr std::size_t transformBatchSize = 16384;
+
+    // screen space barycentric coordinates of vertices of part of clipped
+    // triangle in source triangle
+    using BarycentricMap = std::array<vec::Vec3F, 3>;
+    using ClipPlanes = std::array<vec::Vec4F, 6>;
+    // half-open range of indexes
+    using IndexRange = std::pair<std::size_t, std::size_t>;
+
+    /*
+     * Triangles of chunk are all back facing, all front facing or have to be
+     * tested one by one. Eye is in model space, orientation is sign of
+     * determinant of model matrix, mirroring transformation flips facing.
+     */
+    enum class Facing { Back, Front, Mixed };
+    [[nodiscard]] static Facing chunkFacing(const ent::Model::Chunk &chunk,
+                                            vec::Vec3F eye,
+                                            floating orientation) noexcept;
+
+    struct VisibleChunk {
+        const ent::Model::Chunk *chunk;
+        bool testFacing;
+    };
+    // triangles of which facing is tested if testFacing is set
+    struct TriangleRange {
+        std::size_t first, last;
+        bool testFacing;
+    };
+
+    struct SetUpTriangle {
+        vec::Vec3F a, b, c;
+        std::size_t index;
+        // index of map in bins, noMap if triangle wasn't clipped
+        uint32_t map;
+    };
+    static constexpr uint32_t noMap = std::numeric_limits<uint32_t>::max();
+
+    // triangles of one part of model and their indexes for every tile
+    struct TriangleBins {
+        std::vector<SetUpTriangle> triangles;
+        std::vector<BarycentricMap> maps;
+        std::vector<std::vector<uint32_t>> tiles;
+    };
+
+    // inverse of perspective division, which is done only for w > 0
+    [[nodiscard]] static vec::Vec4F toHomogeneous(Vertex vertex) noexcept;
+
+    // near and far planes and borders of region in screen space
+    [[nodiscard]] static ClipPlanes clipPlanes(floating xMin, floating xMax,
+                                               floating yMin,
+                                               floating yMax) noexcept;
+
+    // screen extended by guard band of screen size to every side, clipping
+    // by it keeps rasterized coordinates small without clipping most of
+    // triangles which are partly out of screen
+    [[nodiscard]] ClipPlanes guardBandPlanes() const noexcept;
+
+    /*
+     * View frustum and eye are moved to model space, so chunks of model are
+     * culled by their bounding boxes and normal cones before any vertex is
+     * transformed. Culled chunks are outside of one of frustum planes or
+     * back facing, so clipping or facing test would drop all their triangles
+     * anyway.
+     */
+    [[nodiscard]] std::vector<VisibleChunk> visibleChunks() const;
+    // triangles of visible chunks in model order, adjacent ranges are merged
+    [[nodiscard]] std::vector<TriangleRange> visibleTriangles() const;
+
+    /*
+     * Triangle inside of all guard band planes is emitted as is, triangle
+     * outside of one of them is dropped, both are found by bits of its
+     * vertices. The rest is clipped in homogeneous space and
+     * emitted as fan of triangles in screen space with map of barycentric
+     * coordinates. Shaders get screen space coordinates, so map holds them
+     * and not homogeneous ones: vertex with homogeneous weights l has
+     * l_i * w_i / sum(l_j * w_j) in screen space, for triangle in front of
+     * camera it's its barycentric coordinates in projected triangle.
+     */
+    template <typename Emit>
+    static void clipTriangle(const Triangle &triangle,
+                             const FrameVertices &frame,
+                             const ClipPlanes &planes, Emit &&emit)
+    {
+        std::array<Vertex, 3> vertices{frame.screen[triangle[0]],
+                                       frame.screen[triangle[1]],
+                                       frame.screen[triangle[2]]};
+        auto a = frame.outside[triangle[0]], b = frame.outside[triangle[1]],
+             c = frame.outside[triangle[2]];
+        if ((a & b & c) != 0)
+            return;
+        if ((a | b | c) == 0) {
+            emit(vertices[0].template trim<3>(),
+                 vertices[1].template trim<3>(),
+                 vertices[2].template trim<3>(), nullptr);
+            return;
+        }
+
+        std::array<vec::Vec4F, 3> homogeneous{toHomogeneous(vertices[0]),
+                                              toHomogeneous(vertices[1]),
+                                              toHomogeneous(vertices[2])};
+        auto polygon = alg::clipTriangle(homogeneous, planes);
+        constexpr auto capacity = decltype(polygon.vertices){}.size();
+        std::array<vec::Vec3F, capacity> screen{};
+        std::array<vec::Vec3F, capacity> weights{};
+        for (std::size_t i = 0; i < polygon.size; i++) {
+            const auto &[position, homogeneousWeights] = polygon.vertices[i];
+            // possible only on near plane with zero distance to camera
+            if (!(position[3] > 0))
+                return;
+            screen[i] = position.template trim<3>() / position[3];
+            vec::Vec3F scaled{homogeneousWeights[0] * homogeneous[0][3],
+                              homogeneousWeights[1] * homogeneous[1][3],
+                              homogeneousWeights[2] * homogeneous[2][3]};
+            weights[i] = scaled / (scaled[0] + scaled[1] + scaled[2]);
+        }
+        for (std::size_t i = 1; i + 1 < polygon.size; i++) {
+            BarycentricMap map{weights[0], weights[i], weights[i + 1]};
+            emit(screen[0], screen[i], screen[i + 1], &map);
+        }
+    }
+
+    // world is vertices of model in world space
+    [[nodiscard]] static bool
+    isFrontFacing(const Triangle &triangle,
+                  std::vector<Vertex>::const_iterator world,
+                  vec::Vec3F cameraEye) noexcept;
+
+    // calls f with index and testFacing of triangles from first to last one
+    // of concatenated ranges
+    template <typename F>
+    static void forEachTriangle(const std::vector<TriangleRange> &ranges,
+                                std::size_t first, std::size_t last, F &&f)
+    {
+        std::size_t offset = 0;
+        for (const auto &range : ranges) {
+            if (offset >= last)
+                return;
+            auto size = range.last - range.first;
+            for (auto i = std::max(first, offset);
+                 i < std::min(last, offset + size); i++)
+                f(range.first + (i - offset), range.testFacing);
+            offset += size;
+        }
+    }
+
+    // coordinates of passed lanes are moved to source triangle by map
+    [[nodiscard]] static PixelPacket
+    packetOf(uint32_t blockX, uint32_t y, uint32_t passed,
+             const RowCoverage &coverage, const Triangle &triangle,
+             const BarycentricMap *map) noexcept;
+
+    // map is nullptr for triangle which wasn't clipped, index is index of
+    // triangle in model
+    template <typename ShaderCallable>
+    void rasterizeTriangle(vec::Vec3F a, vec::Vec3F b, vec::Vec3F c,
+                           alg::PixelRect clip, const Triangle &triangle,
+                           uint32_t index, const BarycentricMap *map,
+                           ShaderCallable &shader)
+    {
+        auto bounds = alg::triangleBounds(a, b, c, clip);
+        auto edges = alg::setupTriangleEdges(a, b, c);
+        if (!bounds || !edges)
+            return;
+        auto nearestZ = std::min({a[2], b[2], c[2]});
+        static_assert(packetSize == alg::rasterizationBlockSize,
+                      "packet is row of rasterization block");
+        RowCoverage coverage{};
+        alg::forEachTriangleBlock(
+            *edges, *bounds, [&](alg::PixelRect block, bool fullyCovered) {
+                if (_depth.isBlockOccluded(*edges, nearestZ, block))
+                    return;
+                auto blockX =
+                    block.xMin & ~(alg::rasterizationBlockSize - 1);
+                auto lanes = ((2u << (block.xMax - blockX)) - 1) &
+                             ~((1u << (block.xMin - blockX)) - 1);
+                bool written = false;
+                for (auto y = block.yMin; y <= block.yMax; y++) {
+                    auto zRow = _depth.row(y) + blockX;
+                    auto passed = _coverRow(*edges, blockX, y, lanes,
+                                            fullyCovered, zRow, coverage);
+                    written = written || passed != 0;
+                    if constexpr (PacketShader<ShaderCallable>) {
+                        if (passed != 0)
+                            shader(packetOf(blockX, y, passed, coverage,
+                                            triangle, map));
+                    } else {
+                        for (; passed != 0; passed &= passed - 1) {
+                            auto lane = static_cast<uint32_t>(
+                                std::countr_zero(passed));
+                            auto u = coverage.u[lane], v = coverage.v[lane],
+                                 w = coverage.w[lane];
+                            if (map) {
+                                auto source = (*map)[0] * u + (*map)[1] * v +
+                                              (*map)[2] * w;
+                                u = source[0];
+                                v = source[1];
+                                w = source[2];
+                            }
+                            if constexpr (Shader<ShaderCallable>)
+                                shader(blockX + lane, y, u, v, w, triangle);
+                            else
+                                shader(blockX + lane, y, u, v, index);
+                        }
+                    }
                 }
+                if (written)
+                    _depth.updateBlockDepth(blockX, block.yMin);
             });
     }
 
-    template <Shader ShaderCallable>
-    void rasterize(std::vector<Vertex>::const_iterator vc,
-                   ShaderCallable &&shader)
+    template <AnyShader ShaderCallable>
+    void rasterizeSequential(const FrameVertices &frame,
+                             ShaderCallable &shader)
     {
-        std::fill(_zBuffer.begin(), _zBuffer.end(), 1);
-        auto zBufferCheck = [zIter = _zBuffer.begin(), xSize = _xSize,
-                             zSize = _zBuffer.size()](uint32_t x, uint32_t y,
-                                                      floating z) {
-            auto index = y * xSize + x;
-            auto point = zIter + index;
-            auto res = index < zSize && z < *point;
-            if (res)
-                *point = z;
-            return res;
+        _depth.clear();
+        if (_depth.xSize() == 0 || _depth.rows() == 0)
+            return;
+        // pixels out of screen are skipped, z-buffer rows have padding
+        auto screen =
+            alg::PixelRect{0, _depth.xSize() - 1, 0, _depth.rows() - 1};
+        auto drawTriangle = [&, planes = guardBandPlanes(),
+                             world = _model.getWorldVertices().cbegin(),
+                             cEye = _camera.getEye()](std::size_t index,
+                                                      bool testFacing) {
+            const auto &triangle =
+                _model.trianglesBegin()[static_cast<std::ptrdiff_t>(index)];
+            if (testFacing && !isFrontFacing(triangle, world, cEye))
+                return;
+            clipTriangle(triangle, frame, planes,
+                         [&](vec::Vec3F a, vec::Vec3F b, vec::Vec3F c,
+                             const BarycentricMap *map) {
+                             rasterizeTriangle(a, b, c, screen, triangle,
+                                               static_cast<uint32_t>(index),
+                                               map, shader);
+                         });
         };
-        std::for_each(
-            _model.trianglesBegin(), _model.trianglesEnd(),
-            [=, zBuffer = std::move(zBufferCheck),
-             svIt = _model.verticesBegin(), cvIt = vc,
-             mMatrix = _model.getModelMatrix(),
-             cEye = _camera.getEye()](auto &&triangle) {
-                auto aInWorldSpace =
-                    (mMatrix * *(svIt + triangle[0].vertexOffset))
-                        .template trim<3>();
-                auto bInWorldSpace =
-                    (mMatrix * *(svIt + triangle[1].vertexOffset))
-                        .template trim<3>();
-                auto cInWorldSpace =
-                    (mMatrix * *(svIt + triangle[2].vertexOffset))
-                        .template trim<3>();
-                auto tNormal = vec::cross(cInWorldSpace - aInWorldSpace,
-                                          bInWorldSpace - aInWorldSpace);
-                auto eyeDirection = aInWorldSpace - cEye;
-                auto normalDotEye = eyeDirection * tNormal;
-                if (normalDotEye >= 0) {
-                    auto a =
-                        (cvIt + triangle[0].vertexOffset)->template trim<3>();
-                    auto b =
-                        (cvIt + triangle[1].vertexOffset)->template trim<3>();
-                    auto c =
-                        (cvIt + triangle[2].vertexOffset)->template trim<3>();
-                    alg::barycentricCoordinates(
-                        a, b, c, zBuffer,
-                        [=](uint32_t x, uint32_t y, floating u, floating v,
-                            floating w) { shader(x, y, u, v, w, triangle); });
-                }
+        for (const auto &range : visibleTriangles())
+            for (auto i = range.first; i < range.last; i++)
+                drawTriangle(i, range.testFacing);
+    }
+
+    template <AnyShader ShaderCallable>
+    void rasterizeBinned(const FrameVertices &frame,
+                         const ShaderCallable &shader)
+    {
+        auto xSize = _depth.xSize(), ySize = _depth.rows();
+        if (xSize == 0 || ySize == 0)
+            return;
+        auto xTiles = (xSize + binnedTileSize - 1) / binnedTileSize;
+        auto yTiles = (ySize + binnedTileSize - 1) / binnedTileSize;
+        std::size_t tilesCount = std::size_t{xTiles} * yTiles;
+
+        // visible triangles are split on parts in order, so every tile later
+        // meets its triangles in the same order as sequential mode does
+        auto trianglesBegin = _model.trianglesBegin();
+        auto visible = visibleTriangles();
+        std::size_t trianglesCount = 0;
+        for (const auto &range : visible)
+            trianglesCount += range.last - range.first;
+        std::size_t partsCount = _workers.size();
+        _bins.resize(partsCount);
+        // world space cache is updated here and only read by workers
+        auto world = _model.getWorldVertices().cbegin();
+        _workers.parallelFor(partsCount, [&, planes = guardBandPlanes(),
+                                          cEye = _camera.getEye()](
+                                             std::size_t part) {
+            auto &bins = _bins[part];
+            bins.triangles.clear();
+            bins.maps.clear();
+            bins.tiles.resize(tilesCount);
+            for (auto &tile : bins.tiles)
+                tile.clear();
+            auto first = trianglesCount * part / partsCount;
+            auto last = trianglesCount * (part + 1) / partsCount;
+            forEachTriangle(visible, first, last, [&](std::size_t i,
+                                                      bool testFacing) {
+                const auto &triangle = *(trianglesBegin +
+                                         static_cast<std::ptrdiff_t>(i));
+                if (testFacing && !isFrontFacing(triangle, world, cEye))
+                    return;
+                clipTriangle(triangle, frame, planes,
+                             [&](vec::Vec3F a, vec::Vec3F b, vec::Vec3F c,
+                                 const BarycentricMap *map) {
+                    // coordinates are inside of guard band, cast can't wrap
+                    auto tileOf = [](floating coordinate, uint32_t tiles) {
+                        auto pixel =
+                            std::max(std::ceil(coordinate), floating{0});
+                        return std::min(static_cast<uint32_t>(pixel) /
+                                            binnedTileSize,
+                                        tiles - 1);
+                    };
+                    auto xFirst = tileOf(std::min({a[0], b[0], c[0]}), xTiles);
+                    auto xLast = tileOf(std::max({a[0], b[0], c[0]}), xTiles);
+                    auto yFirst = tileOf(std::min({a[1], b[1], c[1]}), yTiles);
+                    auto yLast = tileOf(std::max({a[1], b[1], c[1]}), yTiles);
+                    auto mapIndex = noMap;
+                    if (map) {
+                        mapIndex = static_cast<uint32_t>(bins.maps.size());
+                        bins.maps.push_back(*map);
+                    }
+                    auto setUpIndex =
+                        static_cast<uint32_t>(bins.triangles.size());
+                    bins.triangles.push_back({a, b, c, i, mapIndex});
+                    for (auto y = yFirst; y <= yLast; y++)
+                        for (auto x = xFirst; x <= xLast; x++)
+                            bins.tiles[std::size_t{y} * xTiles + x].push_back(
+                                setUpIndex);
+                });
             });
+        });
+
+        _workers.parallelFor(tilesCount, [&](std::size_t tile) {
+            auto xMin = static_cast<uint32_t>(tile % xTiles) * binnedTileSize;
+            auto yMin = static_cast<uint32_t>(tile / xTiles) * binnedTileSize;
+            auto clip = alg::PixelRect{
+                xMin, std::min(xMin + binnedTileSize, xSize) - 1, yMin,
+                std::min(yMin + binnedTileSize, ySize) - 1};
+            _depth.clear(clip);
+            auto tileShader = shader;
+            for (const auto &bins : _bins) {
+                for (auto setUpIndex : bins.tiles[tile]) {
+                    const auto &setUp = bins.triangles[setUpIndex];
+                    rasterizeTriangle(
+                        setUp.a, setUp.b, setUp.c, clip,
+                        *(trianglesBegin +
+                          static_cast<std::ptrdiff_t>(setUp.index)),
+                        static_cast<uint32_t>(setUp.index),
+                        setUp.map == noMap ? nullptr : &bins.maps[setUp.map],
+                        tileShader);
+                }
+            }
+        });
     }
 
-private:
     ent::Model &_model;
     ent::Camera &_camera;
     ent::CameraProjection &_projection;
-    std::vector<floating> _zBuffer;
-    uint32_t _xSize;
+    DepthBuffer _depth;
     ent::ProjectionType _projectionType;
+    RasterizationMode _rasterizationMode;
+    par::WorkerPool _workers;
+    std::vector<TriangleBins> _bins;
+    CoverRow _coverRow;
+    TransformVertices _transform;
+    FrameVertices _frame;
 };
 
 } // namespace eng::pipe
@@ -0,0 +1,83 @@
+#include "LightTiles.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace eng::pipe {
+
+namespace {
+
+// tiles covered by light, inclusive, empty if first > last
+struct TileRect {
+    uint32_t xFirst, xLast, yFirst, yLast;
+};
+
+} // namespace
+
+void LightTiles::build(const ent::LightArray &lights,
+                       const mtr::Matrix &toScreen, uint32_t width,
+                       uint32_t height)
+{
+    _xTiles = (width + tileSize - 1) / tileSize;
+    _yTiles = (height + tileSize - 1) / tileSize;
+    _tiles.resize(std::size_t{_xTiles} * _yTiles);
+    for (auto &tile : _tiles)
+        tile.clear();
+    if (_tiles.empty())
+        return;
+
+    const TileRect wholeScreen{0, _xTiles - 1, 0, _yTiles - 1};
+    for (std::size_t i = 0; i < lights.pointLightsCount(); i++) {
+        auto radius = lights.getPointLightRadius(i);
+        if (!(radius > 0))
+            continue;
+        auto rect = wholeScreen;
+        if (std::isfinite(radius)) {
+            auto center = lights.getPointLightPosition(i);
+            floating xMin = std::numeric_limits<floating>::max();
+            floating yMin = xMin;
+            floating xMax = std::numeric_limits<floating>::lowest();
+            floating yMax = xMax;
+            int behind = 0;
+            for (int corner = 0; corner < 8; corner++) {
+                auto offset = [&](int bit) {
+                    return (corner & bit) != 0 ? radius : -radius;
+                };
+                auto screen =
+                    toScreen * vec::Vec4F{center[0] + offset(1),
+                                          center[1] + offset(2),
+                                          center[2] + offset(4), 1};
+                // depth in clip space is in [0, w]
+                if (screen[2] < 0 || !(screen[3] > 0)) {
+                    behind++;
+                    continue;
+                }
+                xMin = std::min(xMin, screen[0] / screen[3]);
+                xMax = std::max(xMax, screen[0] / screen[3]);
+                yMin = std::min(yMin, screen[1] / screen[3]);
+                yMax = std::max(yMax, screen[1] / screen[3]);
+            }
+            if (behind == 8)
+                continue;
+            if (behind == 0) {
+                auto right = static_cast<floating>(width);
+                auto bottom = static_cast<floating>(height);
+                if (xMax < 0 || yMax < 0 || xMin >= right || yMin >= bottom)
+                    continue;
+                auto tileOf = [](floating coordinate, floating last) {
+                    return static_cast<uint32_t>(
+                               std::clamp(coordinate, floating{0}, last)) /
+                           tileSize;
+                };
+                rect = {tileOf(xMin, right - 1), tileOf(xMax, right - 1),
+                        tileOf(yMin, bottom - 1), tileOf(yMax, bottom - 1)};
+            }
+        }
+        for (auto y = rect.yFirst; y <= rect.yLast; y++)
+            for (auto x = rect.xFirst; x <= rect.xLast; x++)
+                _tiles[std::size_t{y} * _xTiles + x].push_back(
+                    static_cast<uint32_t>(i));
+    }
+}
+
+} // namespace eng::pipe
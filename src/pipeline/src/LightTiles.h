@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../../entities/src/Light.h"
+#include "../../matrix/src/Matrix.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace eng::pipe {
+
+/*
+ * Point lights which can affect pixels of every screen tile, lights are
+ * listed in order they were added, so shading by the list sums them in the
+ * same order as shading by all lights does. Light is bounded by box around
+ * sphere of its influence radius, box crossing near plane covers the whole
+ * screen and box behind it covers nothing.
+ */
+class LightTiles {
+public:
+    static constexpr uint32_t tileSize = 32;
+
+    // toScreen is viewport * projection * view, screen is width x height
+    void build(const ent::LightArray &lights, const mtr::Matrix &toScreen,
+               uint32_t width, uint32_t height);
+
+    [[nodiscard]] std::span<const uint32_t>
+    lightsOf(uint32_t x, uint32_t y) const noexcept
+    {
+        const auto &tile = _tiles[std::size_t{y / tileSize} * _xTiles +
+                                  x / tileSize];
+        return {tile.data(), tile.size()};
+    }
+
+private:
+    uint32_t _xTiles{}, _yTiles{};
+    std::vector<std::vector<uint32_t>> _tiles;
+};
+
+} // namespace eng::pipe
@@ -2,14 +2,21 @@
 
 namespace eng::shader {
 
+const NormalInterpolation::Setup &
+NormalInterpolation::setup(const Triangle &triangle) const
+{
+    return _setup.get(triangle, [this](const Triangle &t) {
+        return Setup{*(_normals + t[0]), *(_normals + t[1]),
+                     *(_normals + t[2])};
+    });
+}
+
 vec::Vec3F NormalInterpolation::operator()([[maybe_unused]] floating u,
                                            [[maybe_unused]] floating v,
                                            [[maybe_unused]] floating w,
                                            Triangle triangle) const noexcept
 {
-    auto aNormal = *(_normals + triangle[0].normalOffset);
-    auto bNormal = *(_normals + triangle[1].normalOffset);
-    auto cNormal = *(_normals + triangle[2].normalOffset);
+    const auto &[aNormal, bNormal, cNormal] = setup(triangle);
     auto normalInPoint =
         Normal{aNormal[0] * u + bNormal[0] * v + cNormal[0] * w,
                aNormal[1] * u + bNormal[1] * v + cNormal[1] * w,
@@ -18,11 +25,30 @@ vec::Vec3F NormalInterpolation::operator()([[maybe_unused]] floating u,
     return normalInPoint;
 }
 
+PacketVec3
+NormalInterpolation::operator()(const PixelPacket &packet) const noexcept
+{
+    const auto &[aNormal, bNormal, cNormal] = setup(packet.triangle);
+    PacketVec3 result;
+    for (std::size_t lane = 0; lane < packetSize; lane++) {
+        auto u = packet.u[lane], v = packet.v[lane], w = packet.w[lane];
+        auto x = aNormal[0] * u + bNormal[0] * v + cNormal[0] * w;
+        auto y = aNormal[1] * u + bNormal[1] * v + cNormal[1] * w;
+        auto z = aNormal[2] * u + bNormal[2] * v + cNormal[2] * w;
+        // the same order of sum as in vector length
+        auto length = std::sqrt(floating{0} + x * x + y * y + z * z);
+        result.x[lane] = x / length;
+        result.y[lane] = y / length;
+        result.z[lane] = z / length;
+    }
+    return result;
+}
+
 vec::Vec3F NormalForTriangle::operator()(Triangle triangle) const noexcept
 {
-    auto a = (*(_vertices + triangle[0].vertexOffset)).trim<3>();
-    auto b = (*(_vertices + triangle[1].vertexOffset)).trim<3>();
-    auto c = (*(_vertices + triangle[2].vertexOffset)).trim<3>();
+    auto a = (*(_vertices + triangle[0])).trim<3>();
+    auto b = (*(_vertices + triangle[1])).trim<3>();
+    auto c = (*(_vertices + triangle[2])).trim<3>();
     return vec::cross(c - a, b - a).normalize();
 }
 
@@ -39,49 +65,67 @@ vec::Vec3F NormalForTriangleWithCaching::operator()(
     }
 }
 
-[[nodiscard]] vec::Vec3<uint8_t> TextureProcessing::getRGB(
-    [[maybe_unused]] floating u, [[maybe_unused]] floating v,
-    [[maybe_unused]] floating w, Triangle triangle) const noexcept
+const TextureProcessing::Setup &
+TextureProcessing::setup(const Triangle &triangle) const
 {
-    auto aCoordinate =
-        *(_texturesCoordinates + triangle[0].textureCoordinatesOffset);
-    auto bCoordinate =
-        *(_texturesCoordinates + triangle[1].textureCoordinatesOffset);
-    auto cCoordinate =
-        *(_texturesCoordinates + triangle[2].textureCoordinatesOffset);
-
-    auto aX = aCoordinate[0] * static_cast<floating>(_width) -
-              static_cast<floating>(0.5);
-    auto aY = (1 - aCoordinate[1]) * static_cast<floating>(_height) -
-              static_cast<floating>(0.5);
-    auto bX = bCoordinate[0] * static_cast<floating>(_width) -
-              static_cast<floating>(0.5);
-    auto bY = (1 - bCoordinate[1]) * static_cast<floating>(_height) -
-              static_cast<floating>(0.5);
-    auto cX = cCoordinate[0] * static_cast<floating>(_width) -
-              static_cast<floating>(0.5);
-    auto cY = (1 - cCoordinate[1]) * static_cast<floating>(_height) -
-              static_cast<floating>(0.5);
-
-    auto aW = (*(_vertices + triangle[0].vertexOffset))[3];
-    auto bW = (*(_vertices + triangle[1].vertexOffset))[3];
-    auto cW = (*(_vertices + triangle[2].vertexOffset))[3];
+    return _setup.get(triangle, [this](const Triangle &t) {
+        auto width = static_cast<floating>(_texture->width());
+        auto height = static_cast<floating>(_texture->height());
+        Setup result{};
+        std::array<vec::Vec2F, 3> texels, pixels;
+        bool inFront = true;
+        for (std::size_t i = 0; i < t.size(); i++) {
+            auto coordinate = *(_texturesCoordinates + t[i]);
+            auto vertex = *(_vertices + t[i]);
+            auto inverseW = 1 / vertex[3];
+            texels[i] = {coordinate[0] * width - static_cast<floating>(0.5),
+                         (1 - coordinate[1]) * height -
+                             static_cast<floating>(0.5)};
+            pixels[i] = {vertex[0], vertex[1]};
+            inFront = inFront && vertex[3] > 0;
+            result.x[i] = texels[i][0] * inverseW;
+            result.y[i] = texels[i][1] * inverseW;
+            result.inverseW[i] = inverseW;
+        }
+        // vertices behind camera aren't projected, full resolution is used
+        auto area = [](const std::array<vec::Vec2F, 3> &corners) {
+            auto ab = corners[1] - corners[0], ac = corners[2] - corners[0];
+            return std::fabs(ab[0] * ac[1] - ab[1] * ac[0]);
+        };
+        result.lod = inFront ? 0.5f * std::log2(area(texels) / area(pixels))
+                             : 0;
+        return result;
+    });
+}
 
-    auto x = std::clamp(
-        static_cast<uint64_t>((aX * u / aW + bX * v / bW + cX * w / cW) /
-                              (u / aW + v / bW + w / cW)),
-        static_cast<uint64_t>(0), static_cast<uint64_t>(_width));
-    auto y = std::clamp(
-        static_cast<uint64_t>((aY * u / aW + bY * v / bW + cY * w / cW) /
-                              (u / aW + v / bW + w / cW)),
-        static_cast<uint64_t>(0), static_cast<uint64_t>(_height));
+vec::Vec3F TextureProcessing::texel(const Setup &plane, floating u, floating v,
+                                    floating w) const noexcept
+{
+    auto toTexture = 1 / (plane.inverseW[0] * u + plane.inverseW[1] * v +
+                          plane.inverseW[2] * w);
+    return _texture->sample(
+        (plane.x[0] * u + plane.x[1] * v + plane.x[2] * w) * toTexture,
+        (plane.y[0] * u + plane.y[1] * v + plane.y[2] * w) * toTexture,
+        plane.lod, _filter);
+}
 
-    auto offset = (y * _width + x) * _channel; // maybe round
-    auto rgbPtr = _textureData + offset;
+[[nodiscard]] vec::Vec3F TextureProcessing::sample(
+    [[maybe_unused]] floating u, [[maybe_unused]] floating v,
+    [[maybe_unused]] floating w, Triangle triangle) const noexcept
+{
+    return texel(setup(triangle), u, v, w);
+}
 
-    auto r = static_cast<uint8_t>(rgbPtr[0]);
-    auto g = static_cast<uint8_t>(rgbPtr[1]);
-    auto b = static_cast<uint8_t>(rgbPtr[2]);
-    return vec::Vec3<uint8_t>{r, g, b};
+void TextureProcessing::sample(
+    const PixelPacket &packet,
+    std::array<vec::Vec3F, packetSize> &values) const noexcept
+{
+    const auto &triangleSetup = setup(packet.triangle);
+    for (auto mask = packet.mask; mask != 0; mask &= mask - 1) {
+        auto lane = static_cast<std::size_t>(std::countr_zero(mask));
+        values[lane] = texel(triangleSetup, packet.u[lane], packet.v[lane],
+                             packet.w[lane]);
+    }
 }
+
 } // namespace eng::shader
@@ -1,7 +1,10 @@
 #pragma once
 #include "../../base/src/Elements.h"
 #include "../../entities/src/Light.h"
+#include "../../entities/src/Texture.h"
 #include "../../matrix/src/Matrix.h"
+#include "LightTiles.h"
+#include <bit>
 #include <cstdint>
 
 namespace eng::shader {
@@ -32,6 +35,75 @@ concept SpecularPropertiesProvider =
         } -> std::convertible_to<vec::Vec3F>;
     };
 
+// provider which gives values of all covered lanes of packet at once
+template <typename T>
+concept PacketProvider = requires(const T provider, const PixelPacket &packet) {
+    {
+        provider(packet)
+    } -> std::convertible_to<PacketVec3>;
+};
+
+// provider without packet version is called for every covered lane,
+// other lanes are zero
+template <typename Provider>
+[[nodiscard]] PacketVec3 provideForPacket(const Provider &provider,
+                                          const PixelPacket &packet) noexcept
+{
+    if constexpr (PacketProvider<Provider>) {
+        return provider(packet);
+    } else {
+        PacketVec3 result{};
+        for (auto mask = packet.mask; mask != 0; mask &= mask - 1) {
+            auto lane = static_cast<std::size_t>(std::countr_zero(mask));
+            auto value = provider(packet.u[lane], packet.v[lane],
+                                  packet.w[lane], packet.triangle);
+            result.x[lane] = value[0];
+            result.y[lane] = value[1];
+            result.z[lane] = value[2];
+        }
+        return result;
+    }
+}
+
+// value for every lane of packet
+[[nodiscard]] inline PacketVec3 broadcast(vec::Vec3F value) noexcept
+{
+    PacketVec3 result;
+    result.x.fill(value[0]);
+    result.y.fill(value[1]);
+    result.z.fill(value[2]);
+    return result;
+}
+
+/*
+ * Values which are computed once for triangle and are used by all its
+ * pixels. They are computed again when pixel of another triangle comes,
+ * shader is copied for every thread which runs it, so cache isn't shared.
+ */
+template <typename Setup> class TriangleSetupCache {
+public:
+    template <typename Compute>
+    [[nodiscard]] const Setup &get(const Triangle &triangle,
+                                   Compute &&compute) const
+    {
+        if (!isCached(triangle)) {
+            _setup = compute(triangle);
+            _triangle = triangle;
+        }
+        return _setup;
+    }
+
+private:
+    [[nodiscard]] bool isCached(const Triangle &triangle) const noexcept
+    {
+        return triangle == _triangle;
+    }
+
+    // no triangle has such indexes, so nothing is cached at start
+    mutable Triangle _triangle{noVertex, noVertex, noVertex};
+    mutable Setup _setup{};
+};
+
 using nci = std::vector<Normal>::const_iterator;
 using vci = std::vector<Vertex>::const_iterator;
 using tci = std::vector<TextureCoord>::const_iterator;
@@ -43,9 +115,18 @@ struct NormalInterpolation {
                           [[maybe_unused]] floating v,
                           [[maybe_unused]] floating w,
                           Triangle triangle) const noexcept;
+    // all lanes are computed, uncovered ones from unspecified coordinates
+    [[nodiscard]] PacketVec3
+    operator()(const PixelPacket &packet) const noexcept;
 
 private:
+    struct Setup {
+        Normal a, b, c;
+    };
+    [[nodiscard]] const Setup &setup(const Triangle &triangle) const;
+
     nci _normals;
+    TriangleSetupCache<Setup> _setup;
 };
 
 struct NormalForTriangle {
@@ -93,6 +174,11 @@ public:
     {
         return vec::Vec3F{1, 1, 1};
     }
+    [[nodiscard]] PacketVec3
+    operator()([[maybe_unused]] const PixelPacket &packet) const noexcept
+    {
+        return broadcast({1, 1, 1});
+    }
     [[nodiscard]] vec::Vec3F getCameraPosition()const noexcept{return _eye;}
     [[nodiscard]] vci getVerticesInWorldSpace()const noexcept{return _verticesInWorldSpace;}
     [[nodiscard]] floating getShine()const noexcept{return _shine;}
@@ -112,6 +198,11 @@ struct ConstantAlbedo {
     {
         return _albedo;
     }
+    [[nodiscard]] PacketVec3
+    operator()([[maybe_unused]] const PixelPacket &packet) const noexcept
+    {
+        return broadcast(_albedo);
+    }
 
 private:
     vec::Vec3F _albedo;
@@ -119,31 +210,49 @@ private:
 
 
 struct TextureProcessing {
-    TextureProcessing(vci vertices, tci textures, const char *textureData,
-                      uint32_t width, uint32_t height, uint8_t channel)
+    // vertices are in viewport space with w of clip space
+    TextureProcessing(vci vertices, tci textures, const ent::Texture &texture,
+                      ent::TextureFilter filter)
         : _vertices(vertices), _texturesCoordinates(textures),
-          _textureData(textureData), _width(width), _height(height),
-          _channel(channel)
+          _texture(&texture), _filter(filter)
     {}
 
-    [[nodiscard]] vec::Vec3<uint8_t> getRGB([[maybe_unused]] floating u,
-                                            [[maybe_unused]] floating v,
-                                            [[maybe_unused]] floating w,
-                                            Triangle triangle) const noexcept;
+    // value of texture, color with channels in [0, 255] or normal
+    [[nodiscard]] vec::Vec3F sample([[maybe_unused]] floating u,
+                                    [[maybe_unused]] floating v,
+                                    [[maybe_unused]] floating w,
+                                    Triangle triangle) const noexcept;
+    // values of covered lanes, coordinates of texture are found once for
+    // packet
+    void sample(const PixelPacket &packet,
+                std::array<vec::Vec3F, packetSize> &values) const noexcept;
 
 private:
+    /*
+     * Texel coordinates of vertices are divided by w of vertex, so they and
+     * 1 / w are linear in screen space. Pixel needs one division to restore
+     * perspective correct coordinates. Level of detail is one for triangle,
+     * it's found from ratio of its areas in texels and in pixels.
+     */
+    struct Setup {
+        std::array<floating, 3> x, y, inverseW;
+        floating lod;
+    };
+    [[nodiscard]] const Setup &setup(const Triangle &triangle) const;
+    [[nodiscard]] vec::Vec3F texel(const Setup &plane, floating u, floating v,
+                                   floating w) const noexcept;
+
     vci _vertices;
     tci _texturesCoordinates;
-    const char *_textureData;
-    uint32_t _width, _height;
-    uint8_t _channel;
+    const ent::Texture *_texture;
+    ent::TextureFilter _filter;
+    TriangleSetupCache<Setup> _setup;
 };
 
 struct TextureAlbedo : private TextureProcessing {
-    TextureAlbedo(vci vertices, tci textures, const char *textureData,
-                  uint32_t width, uint32_t height, uint8_t channel)
-        : TextureProcessing(vertices, textures, textureData, width, height,
-                            channel)
+    TextureAlbedo(vci vertices, tci textures, const ent::Texture &texture,
+                  ent::TextureFilter filter = ent::TextureFilter::Trilinear)
+        : TextureProcessing(vertices, textures, texture, filter)
     {}
 
     inline vec::Vec3F operator()([[maybe_unused]] floating u,
@@ -151,20 +260,31 @@ struct TextureAlbedo : private TextureProcessing {
                                  [[maybe_unused]] floating w,
                                  Triangle triangle) const noexcept
     {
-        auto rgb = getRGB(u, v, w, triangle);
-        return {static_cast<floating>(rgb[0]) / 0xFF,
-                static_cast<floating>(rgb[1]) / 0xFF,
-                static_cast<floating>(rgb[2]) / 0xFF};
+        return sample(u, v, w, triangle) / 0xFF;
+    }
+
+    [[nodiscard]] PacketVec3
+    operator()(const PixelPacket &packet) const noexcept
+    {
+        std::array<vec::Vec3F, packetSize> rgb{};
+        sample(packet, rgb);
+        PacketVec3 result;
+        for (std::size_t lane = 0; lane < packetSize; lane++) {
+            result.x[lane] = rgb[lane][0] / 0xFF;
+            result.y[lane] = rgb[lane][1] / 0xFF;
+            result.z[lane] = rgb[lane][2] / 0xFF;
+        }
+        return result;
     }
 };
 
+// normal map must be built with ent::TextureContent::Normal
 struct TextureNormal : private TextureProcessing {
-    TextureNormal(mtr::Matrix modelMatrix, vci vertices, tci textures,
-                  const char *textureData, uint32_t width, uint32_t height,
-                  uint8_t channel)
-        : TextureProcessing(vertices, textures, textureData, width, height,
-                            channel),
-          _modelMatrix(modelMatrix)
+    TextureNormal(NormalMatrix normalMatrix, vci vertices, tci textures,
+                  const ent::Texture &texture,
+                  ent::TextureFilter filter = ent::TextureFilter::Trilinear)
+        : TextureProcessing(vertices, textures, texture, filter),
+          _normalMatrix(normalMatrix)
     {}
 
     inline vec::Vec3F operator()([[maybe_unused]] floating u,
@@ -172,24 +292,43 @@ struct TextureNormal : private TextureProcessing {
                                  [[maybe_unused]] floating w,
                                  Triangle triangle) const noexcept
     {
-        auto rgb = getRGB(u, v, w, triangle);
-        auto normal =
-            vec::Vec4F{(static_cast<floating>(rgb[0]) / 0xFF) * 2 - 1,
-                       (static_cast<floating>(rgb[1]) / 0xFF) * 2 - 1,
-                       (static_cast<floating>(rgb[2]) / 0xFF) * 2 - 1, 0};
-        return (_modelMatrix * normal).normalize().trim<3>();
+        return toWorld(sample(u, v, w, triangle));
+    }
+
+    [[nodiscard]] PacketVec3
+    operator()(const PixelPacket &packet) const noexcept
+    {
+        std::array<Normal, packetSize> normals{};
+        sample(packet, normals);
+        PacketVec3 result{};
+        for (auto mask = packet.mask; mask != 0; mask &= mask - 1) {
+            auto lane = static_cast<std::size_t>(std::countr_zero(mask));
+            auto normal = toWorld(normals[lane]);
+            result.x[lane] = normal[0];
+            result.y[lane] = normal[1];
+            result.z[lane] = normal[2];
+        }
+        return result;
     }
 
 private:
-    mtr::Matrix _modelMatrix;
+    [[nodiscard]] Normal toWorld(Normal normal) const noexcept
+    {
+        return Normal{_normalMatrix[0] * normal, _normalMatrix[1] * normal,
+                      _normalMatrix[2] * normal}
+            .normalize();
+    }
+
+    NormalMatrix _normalMatrix;
 };
 
 class TextureSpecular : public TextureAlbedo{
 public:
-    TextureSpecular(vci vertices, tci textures, const char *textureData,
-        uint32_t width, uint32_t height, uint8_t channel, vec::Vec3F eye, vci verticesInWorldSpace, floating shine)
-    : TextureAlbedo(vertices, textures, textureData, width, height,
-        channel), _eye(eye), _verticesInWorldSpace(verticesInWorldSpace), _shine(shine)
+    TextureSpecular(vci vertices, tci textures, const ent::Texture &texture,
+                    vec::Vec3F eye, vci verticesInWorldSpace, floating shine,
+                    ent::TextureFilter filter = ent::TextureFilter::Trilinear)
+    : TextureAlbedo(vertices, textures, texture, filter), _eye(eye),
+      _verticesInWorldSpace(verticesInWorldSpace), _shine(shine)
     {}
 
     [[nodiscard]] vec::Vec3F getCameraPosition()const noexcept{return _eye;}
@@ -202,6 +341,10 @@ private:
 
 };
 
+// Pixels shades covered lanes of packet one by one, Packets shades them with
+// vector kernel, which is faster only when most lanes are covered
+enum class PacketShading { Pixels, Packets };
+
 template <AlbedoProvider Albedo, NormalProvider Normal,
           SpecularPropertiesProvider Specular>
 struct PhongShader {
@@ -210,18 +353,114 @@ struct PhongShader {
         : _lights(lights), _albedo(albedo), _normal(normal), _specular(specular)
     {}
 
+    // packet with less covered lanes is shaded pixel by pixel, vector
+    // kernel costs the same for any number of lanes
+    static constexpr int minPacketLanes = 4;
+
+    void setPacketShading(PacketShading shading) noexcept
+    {
+        _packetShading = shading;
+    }
+
+    // point lights are taken from tile of pixel if tiles are set
+    void setLightTiles(const pipe::LightTiles *tiles) noexcept
+    {
+        _tiles = tiles;
+    }
+
     [[nodiscard]] vec::Vec3F operator()([[maybe_unused]] floating u,
                     [[maybe_unused]] floating v, [[maybe_unused]] floating w,
                     Triangle triangle) const noexcept{
+        return shade(u, v, w, triangle, [&](auto &&...arguments) {
+            return _lights.calculatePhongColor(arguments...);
+        });
+    }
+
+    [[nodiscard]] vec::Vec3F operator()(uint32_t x, uint32_t y, floating u,
+                                        floating v, floating w,
+                                        Triangle triangle) const noexcept
+    {
+        if (!_tiles)
+            return (*this)(u, v, w, triangle);
+        return shade(u, v, w, triangle, [&](auto &&...arguments) {
+            return _lights.calculatePhongColor(arguments...,
+                                               _tiles->lightsOf(x, y));
+        });
+    }
+
+    /*
+     * Covered lanes get the same colors as per pixel shading gives them.
+     * Packet is part of row of aligned rasterization block, so it's inside
+     * of one light tile.
+     */
+    [[nodiscard]] PacketVec3
+    operator()(const PixelPacket &packet) const noexcept
+    {
+        static_assert(pipe::LightTiles::tileSize % packetSize == 0,
+                      "packet doesn't cross light tiles");
+        if (_packetShading == PacketShading::Pixels ||
+            std::popcount(packet.mask) < minPacketLanes) {
+            PacketVec3 color{};
+            for (auto mask = packet.mask; mask != 0; mask &= mask - 1) {
+                auto lane = static_cast<uint32_t>(std::countr_zero(mask));
+                auto value = (*this)(packet.x + lane, packet.y, packet.u[lane],
+                                     packet.v[lane], packet.w[lane],
+                                     packet.triangle);
+                color.x[lane] = value[0];
+                color.y[lane] = value[1];
+                color.z[lane] = value[2];
+            }
+            return color;
+        }
+        auto albedo = provideForPacket(_albedo, packet);
+        auto normal = provideForPacket(_normal, packet);
+        auto specularProperties = provideForPacket(_specular, packet);
+        auto shine = _specular.getShine();
+        auto cameraPosition = _specular.getCameraPosition();
+        const auto &[a, b, c] = worldVertices(packet.triangle);
+        PacketVec3 point;
+        for (std::size_t lane = 0; lane < packetSize; lane++) {
+            auto u = packet.u[lane], v = packet.v[lane], w = packet.w[lane];
+            point.x[lane] = a[0] * u + b[0] * v + c[0] * w;
+            point.y[lane] = a[1] * u + b[1] * v + c[1] * w;
+            point.z[lane] = a[2] * u + b[2] * v + c[2] * w;
+        }
+        auto [ambient, diffuse, specular] =
+            _tiles ? _lights.calculatePhongColor(
+                         point, normal, albedo, specularProperties,
+                         cameraPosition, shine,
+                         _tiles->lightsOf(packet.x, packet.y))
+                   : _lights.calculatePhongColor(point, normal, albedo,
+                                                 specularProperties,
+                                                 cameraPosition, shine);
+        PacketVec3 color;
+        for (std::size_t lane = 0; lane < packetSize; lane++) {
+            color.x[lane] = std::clamp(
+                diffuse.x[lane] + ambient.x[lane] + specular.x[lane], 0.f,
+                255.f);
+            color.y[lane] = std::clamp(
+                diffuse.y[lane] + ambient.y[lane] + specular.y[lane], 0.f,
+                255.f);
+            color.z[lane] = std::clamp(
+                diffuse.z[lane] + ambient.z[lane] + specular.z[lane], 0.f,
+                255.f);
+        }
+        return color;
+    }
+
+private:
+    template <typename Lighting>
+    [[nodiscard]] vec::Vec3F shade(floating u, floating v, floating w,
+                                   Triangle triangle,
+                                   Lighting &&lighting) const noexcept
+    {
         auto albedo = _albedo(u, v, w, triangle);
         auto normal = _normal(u, v, w, triangle);
         auto specularProperties= _specular(u, v, w, triangle);
-        auto verticesInWorldSpace = _specular.getVerticesInWorldSpace();
         auto shine = _specular.getShine();
         auto cameraPosition = _specular.getCameraPosition();
-        auto aInWorldSpace = *(verticesInWorldSpace + triangle[0].vertexOffset);
-        auto bInWorldSpace = *(verticesInWorldSpace + triangle[1].vertexOffset);
-        auto cInWorldSpace = *(verticesInWorldSpace + triangle[2].vertexOffset);
+        const auto &[aInWorldSpace, bInWorldSpace, cInWorldSpace] =
+            worldVertices(triangle);
         auto point =
             vec::Vec3F{aInWorldSpace[0] * u + bInWorldSpace[0] * v +
                        cInWorldSpace[0] * w,
@@ -229,14 +468,9 @@ struct PhongShader {
                        cInWorldSpace[1] * w,
                        aInWorldSpace[2] * u + bInWorldSpace[2] * v +
                        cInWorldSpace[2] * w};
-        vec::Vec3F diffuseIntensity{}, ambientIntensity{}, specularIntensity{};
-
-        for(const auto& light : _lights){
-            auto [ambient, diffuse, specular] = light->calculatePhongColor(point, normal, albedo, specularProperties, cameraPosition, shine);
-            diffuseIntensity +=  diffuse;
-            ambientIntensity += ambient;
-            specularIntensity += specular;
-        }
+        auto [ambientIntensity, diffuseIntensity, specularIntensity] =
+            lighting(point, normal, albedo, specularProperties,
+                     cameraPosition, shine);
 
         return vec::Vec3F {
             std::clamp(diffuseIntensity[0] + ambientIntensity[0] +
@@ -251,11 +485,23 @@ struct PhongShader {
         };
     }
 
-private:
+    [[nodiscard]] const std::array<Vertex, 3> &
+    worldVertices(const Triangle &triangle) const
+    {
+        return _worldVertices.get(triangle, [this](const Triangle &t) {
+            auto vertices = _specular.getVerticesInWorldSpace();
+            return std::array{*(vertices + t[0]), *(vertices + t[1]),
+                              *(vertices + t[2])};
+        });
+    }
+
     const ent::LightArray& _lights;
     Albedo _albedo;
     Normal _normal;
     Specular _specular;
+    const pipe::LightTiles *_tiles{nullptr};
+    PacketShading _packetShading{PacketShading::Pixels};
+    TriangleSetupCache<std::array<Vertex, 3>> _worldVertices;
 };
 
 
@@ -0,0 +1,136 @@
+#include "TransformKernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ENG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace eng::pipe {
+
+namespace {
+
+void transformScalar(const mtr::MatrixRepresentation &matrix,
+                     bool perspectiveDivide, const VertexStreams &positions,
+                     std::size_t first, std::size_t last, Vertex *out) noexcept
+{
+    for (auto i = first; i < last; i++) {
+        Vertex vertex{positions.x[i], positions.y[i], positions.z[i],
+                      positions.w[i]};
+        Vertex result;
+        for (std::size_t row = 0; row < 4; row++) {
+            floating sum{};
+            for (std::size_t column = 0; column < 4; column++)
+                sum += matrix[row][column] * vertex[column];
+            result[row] = sum;
+        }
+        if (perspectiveDivide && result[3] > 0)
+            for (std::size_t j = 0; j < 3; j++)
+                result[j] /= result[3];
+        out[i] = result;
+    }
+}
+
+#ifdef ENG_X86_KERNELS
+
+// row * (x, y, z, w) accumulated from zero as scalar kernel does
+__attribute__((target("avx2"))) __m256 rowProductAVX2(
+    const std::array<floating, 4> &row, __m256 x, __m256 y, __m256 z,
+    __m256 w) noexcept
+{
+    auto sum = _mm256_add_ps(_mm256_setzero_ps(),
+                             _mm256_mul_ps(_mm256_set1_ps(row[0]), x));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(row[1]), y));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(row[2]), z));
+    return _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(row[3]), w));
+}
+
+__attribute__((target("avx2"))) void
+transformAVX2(const mtr::MatrixRepresentation &matrix, bool perspectiveDivide,
+              const VertexStreams &positions, std::size_t first,
+              std::size_t last, Vertex *out) noexcept
+{
+    static_assert(sizeof(Vertex) == 4 * sizeof(floating),
+                  "vertex is stored as 4 packed coordinates");
+    auto i = first;
+    for (; i + 8 <= last; i += 8) {
+        auto x = _mm256_loadu_ps(positions.x.data() + i);
+        auto y = _mm256_loadu_ps(positions.y.data() + i);
+        auto z = _mm256_loadu_ps(positions.z.data() + i);
+        auto w = _mm256_loadu_ps(positions.w.data() + i);
+        auto resultX = rowProductAVX2(matrix[0], x, y, z, w);
+        auto resultY = rowProductAVX2(matrix[1], x, y, z, w);
+        auto resultZ = rowProductAVX2(matrix[2], x, y, z, w);
+        auto resultW = rowProductAVX2(matrix[3], x, y, z, w);
+        if (perspectiveDivide) {
+            auto divided =
+                _mm256_cmp_ps(resultW, _mm256_setzero_ps(), _CMP_GT_OQ);
+            resultX = _mm256_blendv_ps(
+                resultX, _mm256_div_ps(resultX, resultW), divided);
+            resultY = _mm256_blendv_ps(
+                resultY, _mm256_div_ps(resultY, resultW), divided);
+            resultZ = _mm256_blendv_ps(
+                resultZ, _mm256_div_ps(resultZ, resultW), divided);
+        }
+        // transpose 4 streams of 8 coordinates to 8 vertices, 128 bit half
+        // of every register holds one vertex
+        auto xyLow = _mm256_unpacklo_ps(resultX, resultY);
+        auto xyHigh = _mm256_unpackhi_ps(resultX, resultY);
+        auto zwLow = _mm256_unpacklo_ps(resultZ, resultW);
+        auto zwHigh = _mm256_unpackhi_ps(resultZ, resultW);
+        auto v04 = _mm256_shuffle_ps(xyLow, zwLow, 0x44);
+        auto v15 = _mm256_shuffle_ps(xyLow, zwLow, 0xee);
+        auto v26 = _mm256_shuffle_ps(xyHigh, zwHigh, 0x44);
+        auto v37 = _mm256_shuffle_ps(xyHigh, zwHigh, 0xee);
+        _mm_storeu_ps(out[i].data(), _mm256_castps256_ps128(v04));
+        _mm_storeu_ps(out[i + 1].data(), _mm256_castps256_ps128(v15));
+        _mm_storeu_ps(out[i + 2].data(), _mm256_castps256_ps128(v26));
+        _mm_storeu_ps(out[i + 3].data(), _mm256_castps256_ps128(v37));
+        _mm_storeu_ps(out[i + 4].data(), _mm256_extractf128_ps(v04, 1));
+        _mm_storeu_ps(out[i + 5].data(), _mm256_extractf128_ps(v15, 1));
+        _mm_storeu_ps(out[i + 6].data(), _mm256_extractf128_ps(v26, 1));
+        _mm_storeu_ps(out[i + 7].data(), _mm256_extractf128_ps(v37, 1));
+    }
+    transformScalar(matrix, perspectiveDivide, positions, i, last, out);
+}
+
+#endif
+
+} // namespace
+
+bool isSupported(TransformKernel kernel) noexcept
+{
+    switch (kernel) {
+    case TransformKernel::Scalar:
+        return true;
+#ifdef ENG_X86_KERNELS
+    case TransformKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+TransformKernel bestTransformKernel() noexcept
+{
+    static const auto best = isSupported(TransformKernel::AVX2)
+                                 ? TransformKernel::AVX2
+                                 : TransformKernel::Scalar;
+    return best;
+}
+
+TransformVertices transformFunction(TransformKernel kernel) noexcept
+{
+    if (!isSupported(kernel))
+        return transformScalar;
+    switch (kernel) {
+#ifdef ENG_X86_KERNELS
+    case TransformKernel::AVX2:
+        return transformAVX2;
+#endif
+    default:
+        return transformScalar;
+    }
+}
+
+} // namespace eng::pipe
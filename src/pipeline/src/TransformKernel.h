@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../../base/src/Elements.h"
+#include "../../matrix/src/Matrix.h"
+#include <cstddef>
+
+namespace eng::pipe {
+
+/*
+ * Transforms vertices from first to last one of positions by matrix and
+ * stores them to out[first..last). If perspectiveDivide is set, x, y and z
+ * of vertex with w > 0 are divided by w. Sum of products is accumulated in
+ * the same order as mtr::Matrix::operator* does.
+ */
+using TransformVertices = void (*)(const mtr::MatrixRepresentation &matrix,
+                                   bool perspectiveDivide,
+                                   const VertexStreams &positions,
+                                   std::size_t first, std::size_t last,
+                                   Vertex *out) noexcept;
+
+// all kernels give bitwise equal results, vector one transforms 8 vertices
+// per iteration
+enum class TransformKernel { Scalar, AVX2 };
+
+[[nodiscard]] bool isSupported(TransformKernel kernel) noexcept;
+// the widest kernel which processor supports
+[[nodiscard]] TransformKernel bestTransformKernel() noexcept;
+// scalar kernel is returned for unsupported one
+[[nodiscard]] TransformVertices
+transformFunction(TransformKernel kernel) noexcept;
+
+} // namespace eng::pipe
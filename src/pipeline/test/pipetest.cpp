@@ -0,0 +1,550 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "../../entities/src/Buffers.h"
+#include "../src/CoverageKernel.h"
+#include "../src/DepthBuffer.h"
+#include "../src/GraphicsPipeline.h"
+#include "../src/LightTiles.h"
+#include "../src/Shaders.h"
+#include "../src/TransformKernel.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <doctest/doctest.h>
+#include <random>
+#include <vector>
+
+using namespace eng;
+using namespace eng::pipe;
+
+TEST_CASE("Coverage kernels give the same result as scalar one")
+{
+    auto scalar = coverRowFunction(CoverageKernel::Scalar);
+    std::mt19937 mt(3);
+    std::uniform_real_distribution coordinate(-4.0f, 36.0f);
+    std::uniform_real_distribution depth(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> lanesMask(1, 255);
+    for (auto kernel : {CoverageKernel::SSE, CoverageKernel::AVX2}) {
+        if (!isSupported(kernel))
+            continue;
+        auto vector = coverRowFunction(kernel);
+        for (unsigned i = 0; i < 300; i++) {
+            auto edges = alg::setupTriangleEdges(
+                {coordinate(mt), coordinate(mt), depth(mt)},
+                {coordinate(mt), coordinate(mt), depth(mt)},
+                {coordinate(mt), coordinate(mt), depth(mt)});
+            if (!edges)
+                continue;
+            for (uint32_t y = 0; y < 32; y++) {
+                for (uint32_t blockX = 0; blockX < 32; blockX += 8) {
+                    std::vector<floating> expectedZ(8), actualZ(8);
+                    for (auto &z : expectedZ)
+                        z = depth(mt);
+                    actualZ = expectedZ;
+                    auto lanes = lanesMask(mt);
+                    RowCoverage expected{}, actual{};
+                    auto expectedMask = scalar(*edges, blockX, y, lanes, false,
+                                               expectedZ.data(), expected);
+                    auto actualMask = vector(*edges, blockX, y, lanes, false,
+                                             actualZ.data(), actual);
+                    REQUIRE(actualMask == expectedMask);
+                    CHECK((actualMask & ~lanes) == 0);
+                    CHECK(actualZ == expectedZ);
+                    for (auto mask = actualMask; mask != 0; mask &= mask - 1) {
+                        auto lane =
+                            static_cast<std::size_t>(std::countr_zero(mask));
+                        CHECK(actual.u[lane] == expected.u[lane]);
+                        CHECK(actual.v[lane] == expected.v[lane]);
+                        CHECK(actual.w[lane] == expected.w[lane]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Coverage kernels keep depth of lanes which are not tested")
+{
+    auto edges = alg::setupTriangleEdges({-10, -10, 0.5f}, {100, -10, 0.5f},
+                                         {-10, 100, 0.5f});
+    REQUIRE(edges);
+    for (auto kernel : {CoverageKernel::Scalar, CoverageKernel::SSE,
+                        CoverageKernel::AVX2}) {
+        auto cover = coverRowFunction(kernel);
+        std::vector<floating> z(8, 1);
+        std::vector<floating> expected{1, 1, 0.5f, 0.5f, 0.5f, 0.5f, 1, 1};
+        RowCoverage coverage{};
+        auto passed = cover(*edges, 8, 4, 0b00111100, true, z.data(), coverage);
+        CHECK(passed == 0b00111100);
+        CHECK(z == expected);
+        // the same depth doesn't pass test again
+        CHECK(cover(*edges, 8, 4, 0xff, true, z.data(), coverage) ==
+              0b11000011);
+    }
+}
+
+TEST_CASE("Blocks behind drawn triangles are rejected")
+{
+    DepthBuffer depth;
+    depth.resize(32 * 32, 32);
+    depth.clear();
+    auto draw = [&depth](vec::Vec3F a, vec::Vec3F b, vec::Vec3F c) {
+        alg::barycentricCoordinates(
+            a, b, c, alg::PixelRect{0, 31, 0, 31},
+            [&depth](uint32_t x, uint32_t y, floating z) {
+                auto &stored = depth.row(y)[x];
+                if (z >= stored)
+                    return false;
+                stored = z;
+                return true;
+            },
+            [](uint32_t, uint32_t, floating, floating, floating) {});
+        for (uint32_t y = 0; y < 32; y += 8)
+            for (uint32_t x = 0; x < 32; x += 8)
+                depth.updateBlockDepth(x, y);
+    };
+    auto block = [](uint32_t x, uint32_t y) {
+        return alg::PixelRect{x, x + 7, y, y + 7};
+    };
+    auto plane = [](floating z) {
+        return *alg::setupTriangleEdges({0, 0, z}, {31, 0, z}, {0, 31, z});
+    };
+
+    // occluder covers left half of buffer
+    draw({-0.5f, -0.5f, 0.5f}, {15.5f, -0.5f, 0.5f}, {-0.5f, 31.5f, 0.5f});
+    draw({15.5f, -0.5f, 0.5f}, {15.5f, 31.5f, 0.5f}, {-0.5f, 31.5f, 0.5f});
+    CHECK(depth.isBlockOccluded(plane(0.7f), 0.7f, block(0, 0)));
+    CHECK(depth.isBlockOccluded(plane(0.7f), 0.7f, block(8, 24)));
+    // depth of pixel may be a bit nearer, so the same one isn't rejected
+    CHECK_FALSE(depth.isBlockOccluded(plane(0.5f), 0.5f, block(0, 0)));
+    CHECK_FALSE(depth.isBlockOccluded(plane(0.3f), 0.3f, block(0, 0)));
+    CHECK_FALSE(depth.isBlockOccluded(plane(0.7f), 0.7f, block(16, 0)));
+    // plane of triangle below buffer comes nearer than occluder only out of
+    // triangle, which is bounded by its nearest vertex
+    auto sloped = *alg::setupTriangleEdges({0, 40, 0.6f}, {31, 40, 0.6f},
+                                           {0, 60, 0.9f});
+    CHECK_FALSE(depth.isBlockOccluded(sloped, 0.1f, block(0, 24)));
+    CHECK(depth.isBlockOccluded(sloped, 0.6f, block(0, 24)));
+
+    // nearer triangle lowers bound of blocks it covers entirely
+    draw({-0.5f, -0.5f, 0.2f}, {7.5f, -0.5f, 0.2f}, {-0.5f, 7.5f, 0.2f});
+    draw({7.5f, -0.5f, 0.2f}, {7.5f, 7.5f, 0.2f}, {-0.5f, 7.5f, 0.2f});
+    CHECK(depth.isBlockOccluded(plane(0.3f), 0.3f, block(0, 0)));
+    CHECK_FALSE(depth.isBlockOccluded(plane(0.3f), 0.3f, block(8, 0)));
+
+    // cleared region passes everything again
+    depth.clear(alg::PixelRect{0, 15, 0, 15});
+    CHECK_FALSE(depth.isBlockOccluded(plane(0.9f), 0.9f, block(0, 0)));
+    CHECK(depth.isBlockOccluded(plane(0.9f), 0.9f, block(0, 16)));
+}
+
+TEST_CASE("Transform kernels give the same result as matrix multiplication")
+{
+    std::mt19937 mt(5);
+    std::uniform_real_distribution coordinate(-10.0f, 10.0f);
+    VertexStreams positions;
+    // w <= 0 is kept for some vertices, count isn't multiple of 8
+    for (unsigned i = 0; i < 203; i++) {
+        positions.x.push_back(coordinate(mt));
+        positions.y.push_back(coordinate(mt));
+        positions.z.push_back(coordinate(mt));
+        positions.w.push_back(i % 5 == 0 ? 1 : coordinate(mt));
+    }
+    auto matrix = mtr::Matrix::getViewport(0, 640, 0, 480) *
+                  mtr::Matrix::getPerspectiveProjectionWithAngle(1.5f, 1.3f,
+                                                                 0.1f, 50) *
+                  mtr::Matrix::getRotateX(0.3f) *
+                  mtr::Matrix::getMove({0.5f, -1, -3});
+    for (auto kernel : {TransformKernel::Scalar, TransformKernel::AVX2}) {
+        if (!isSupported(kernel))
+            continue;
+        auto transform = transformFunction(kernel);
+        for (bool perspectiveDivide : {false, true}) {
+            std::vector<Vertex> out(positions.x.size());
+            transform(matrix.getRepresentation(), perspectiveDivide, positions,
+                      3, out.size(), out.data());
+            CHECK(out[0] == Vertex{});
+            for (std::size_t i = 3; i < out.size(); i++) {
+                auto expected =
+                    matrix * Vertex{positions.x[i], positions.y[i],
+                                    positions.z[i], positions.w[i]};
+                if (perspectiveDivide && expected[3] > 0)
+                    for (std::size_t j = 0; j < 3; j++)
+                        expected[j] /= expected[3];
+                CHECK(out[i] == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Outcodes of vertices accept, reject or clip triangles")
+{
+    // connected strip, so triangles share chunk which is in frustum: the
+    // first one is on screen, the last one is beyond guard band and the
+    // middle one crosses it
+    ent::Model model{{{-1, -1, 0, 1},
+                      {1, -1, 0, 1},
+                      {0, 1, 0, 1},
+                      {40, 0, 0, 1},
+                      {50, 0, 0, 1},
+                      {45, 5, 0, 1}},
+                     {Triangle{0, 1, 2}, Triangle{2, 1, 3}, Triangle{3, 4, 5}}};
+    REQUIRE(model.getChunks().size() == 1);
+    // eye is in spherical coordinates, it is at z = 5
+    ent::Camera camera{{5, 0, 0}, {0, 0, 0}, {0, 1, 0}};
+    ent::CameraProjection projection{64, 64, 0.1f, 100, 90};
+    GraphicsPipeline pipe{model, camera, projection};
+    pipe.setZBufferSize(64 * 64, 64);
+
+    const auto &frame = pipe.applyVertexTransformations(0, 64, 0, 64);
+    for (std::size_t i = 0; i < 3; i++)
+        CHECK(frame.outside[i] == 0);
+    CHECK(frame.outside[3] != 0);
+    CHECK((frame.outside[3] & frame.outside[4] & frame.outside[5]) != 0);
+
+    for (auto mode :
+         {RasterizationMode::Sequential, RasterizationMode::Binned}) {
+        pipe.setRasterizationMode(mode);
+        // binned mode shades tiles concurrently
+        std::array<std::atomic<unsigned>, 3> pixels{};
+        std::atomic<bool> outOfTriangle{false};
+        pipe.rasterize(frame, [&](uint32_t, uint32_t, floating u, floating v,
+                                  uint32_t triangle) {
+            if (u < -1e-3f || v < -1e-3f || u + v > 1 + 1e-3f)
+                outOfTriangle = true;
+            pixels[triangle]++;
+        });
+        CHECK_FALSE(outOfTriangle);
+        CHECK(pixels[0] > 0);
+        // clipped part is on screen
+        CHECK(pixels[1] > 0);
+        CHECK(pixels[2] == 0);
+    }
+}
+
+// square of two triangles facing +z, centered at z axis
+ent::Model square(floating halfSize, floating z)
+{
+    return ent::Model{{{-halfSize, -halfSize, z, 1},
+                       {halfSize, -halfSize, z, 1},
+                       {halfSize, halfSize, z, 1},
+                       {-halfSize, halfSize, z, 1}},
+                      {Triangle{0, 1, 2}, Triangle{0, 2, 3}}};
+}
+
+// pixels of visibility buffer which have triangle, and z of its first vertex
+std::vector<std::pair<std::size_t, floating>>
+visibleDepths(const ent::Model &model, const ent::VisibilityBuffer &buffer)
+{
+    std::vector<std::pair<std::size_t, floating>> visible;
+    buffer.forEachVisible([&](std::size_t pixel, floating, floating, floating,
+                              uint32_t triangle) {
+        auto first = model.trianglesBegin()[triangle][0];
+        visible.emplace_back(pixel, model.vertex(first)[2]);
+    });
+    return visible;
+}
+
+TEST_CASE("Visibility buffer keeps the nearest triangle of every pixel")
+{
+    // eye is in spherical coordinates, it is at z = 5
+    ent::Camera camera{{5, 0, 0}, {0, 0, 0}, {0, 1, 0}};
+    ent::CameraProjection projection{64, 64, 0.1f, 100, 90};
+    // every square alone gives pixels it covers
+    std::vector<floating> depths{-0.5f, 0, 0.5f};
+    std::vector<floating> halfSizes{1.5f, 1, 0.5f};
+    std::vector<std::vector<std::pair<std::size_t, floating>>> alone;
+    for (std::size_t i = 0; i < depths.size(); i++) {
+        auto model = square(halfSizes[i], depths[i]);
+        GraphicsPipeline pipe{model, camera, projection};
+        pipe.setZBufferSize(64 * 64, 64);
+        ent::VisibilityBuffer buffer(64 * 64, 64);
+        pipe.rasterize(pipe.applyVertexTransformations(0, 64, 0, 64),
+                       std::ref(buffer));
+        alone.push_back(visibleDepths(model, buffer));
+        REQUIRE_FALSE(alone.back().empty());
+    }
+    // nearer square wins, so it's drawn over farther ones
+    std::vector<floating> expected(64 * 64, -1);
+    for (const auto &pixels : alone)
+        for (auto [pixel, z] : pixels)
+            expected[pixel] = z;
+
+    // far to near and near to far orders test overwriting and rejection
+    for (bool nearFirst : {false, true}) {
+        std::vector<Vertex> vertices;
+        std::vector<Triangle> triangles;
+        for (std::size_t k = 0; k < depths.size(); k++) {
+            auto i = nearFirst ? depths.size() - 1 - k : k;
+            auto model = square(halfSizes[i], depths[i]);
+            auto first = static_cast<uint32_t>(vertices.size());
+            for (std::size_t v = 0; v < model.verticesCount(); v++)
+                vertices.push_back(model.vertex(v));
+            for (auto t = model.trianglesBegin(); t != model.trianglesEnd();
+                 t++)
+                triangles.push_back(Triangle{(*t)[0] + first,
+                                             (*t)[1] + first,
+                                             (*t)[2] + first});
+        }
+        ent::Model model{std::move(vertices), std::move(triangles)};
+        GraphicsPipeline pipe{model, camera, projection};
+        pipe.setZBufferSize(64 * 64, 64);
+        ent::VisibilityBuffer buffer(64 * 64, 64);
+        for (auto mode :
+             {RasterizationMode::Sequential, RasterizationMode::Binned}) {
+            pipe.setRasterizationMode(mode);
+            buffer.clean();
+            pipe.rasterize(pipe.applyVertexTransformations(0, 64, 0, 64),
+                           std::ref(buffer));
+            std::vector<floating> actual(64 * 64, -1);
+            unsigned visits = 0;
+            for (auto [pixel, z] : visibleDepths(model, buffer)) {
+                actual[pixel] = z;
+                visits++;
+            }
+            CHECK(visits == std::count_if(expected.cbegin(), expected.cend(),
+                                          [](floating z) { return z != -1; }));
+            CHECK(actual == expected);
+        }
+    }
+}
+
+TEST_CASE("Parallel resolve gives the same frame as sequential one")
+{
+    ent::Model model{{{-1.5f, -1.5f, 0, 1},
+                      {1.5f, -1.5f, -0.5f, 1},
+                      {1.5f, 1.5f, 0, 1},
+                      {-1.5f, 1.5f, 0.5f, 1}},
+                     {Triangle{0, 1, 2}, Triangle{0, 2, 3}},
+                     {Normal{-0.3f, -0.2f, 1}.normalize(),
+                      Normal{0.4f, -0.1f, 1}.normalize(),
+                      Normal{0.2f, 0.3f, 1}.normalize(),
+                      Normal{-0.1f, 0.5f, 1}.normalize()}};
+    // eye is in spherical coordinates, it is at z = 5
+    ent::Camera camera{{5, 0, 0}, {0, 0, 0}, {0, 1, 0}};
+    ent::CameraProjection projection{64, 64, 0.1f, 100, 90};
+    GraphicsPipeline pipe{model, camera, projection};
+    pipe.setZBufferSize(64 * 64, 64);
+    ent::VisibilityBuffer buffer(64 * 64, 64);
+    pipe.rasterize(pipe.applyVertexTransformations(0, 64, 0, 64),
+                   std::ref(buffer));
+
+    ent::LightArray lights;
+    lights.push_back(ent::DistantLight{{0, 0.6f, 0.8f}, {255, 255, 255}, 0.2f});
+    lights.push_back(ent::PointLight{{1, 1, 2}, {200, 100, 50}, 0.1f, 1, 0.5f,
+                                     0.1f});
+    lights.prepareSpecular(16);
+    LightTiles tiles;
+    pipe.cullLights(0, 64, 0, 64, lights, tiles);
+    const auto &world = model.getWorldVertices();
+    shader::NoTexturePhongShader shader{lights,
+                                        world.cbegin(),
+                                        model.getWorldNormals().cbegin(),
+                                        {0.5f, 0.7f, 0.9f},
+                                        camera.getEye(),
+                                        16};
+    shader.setLightTiles(&tiles);
+
+    // out is called concurrently, but every pixel only once
+    std::vector<vec::Vec3F> parallel(64 * 64, vec::Vec3F{-1, -1, -1});
+    pipe.resolve(buffer, shader,
+                 [&](uint32_t x, uint32_t y, vec::Vec3F color) {
+                     parallel[std::size_t{y} * 64 + x] = color;
+                 });
+    std::vector<vec::Vec3F> sequential(64 * 64, vec::Vec3F{-1, -1, -1});
+    auto sequentialShader = shader;
+    buffer.forEachVisible([&](std::size_t pixel, floating u, floating v,
+                              floating w, uint32_t triangle) {
+        auto x = static_cast<uint32_t>(pixel % 64);
+        auto y = static_cast<uint32_t>(pixel / 64);
+        sequential[pixel] = sequentialShader(
+            x, y, u, v, w, model.trianglesBegin()[triangle]);
+    });
+    CHECK(std::any_of(sequential.cbegin(), sequential.cend(),
+                      [](vec::Vec3F color) { return color[0] >= 0; }));
+    for (std::size_t pixel = 0; pixel < sequential.size(); pixel++)
+        for (std::size_t i = 0; i < 3; i++)
+            CHECK(std::bit_cast<uint32_t>(parallel[pixel][i]) ==
+                  std::bit_cast<uint32_t>(sequential[pixel][i]));
+}
+
+TEST_CASE("Point lights are listed in tiles they can affect")
+{
+    auto light = [](vec::Vec3F position, floating constant, floating linear) {
+        return ent::PointLight{position, {255, 255, 255}, 0.2f,
+                               constant, linear, 0};
+    };
+    ent::LightArray lights;
+    lights.push_back(ent::DistantLight{{0, 0, 1}, {255, 255, 255}, 0.2f});
+    // right part of screen, x axis of view is opposite to world one
+    lights.push_back(light({-3, 0, -10}, 1, 1000));
+    // crosses near plane
+    lights.push_back(light({0, 0, 0.5f}, 1, 1000));
+    // behind camera
+    lights.push_back(light({0, 0, 20}, 1, 1000));
+    // negligible at any distance
+    lights.push_back(light({0, 0, -10}, 3000, 0));
+    // isn't attenuated by distance
+    lights.push_back(light({0, 0, -1000}, 1, 0));
+    CHECK(lights.getPointLightRadius(0) > 2);
+    CHECK(lights.getPointLightRadius(0) < 2.5f);
+    CHECK(lights.getPointLightRadius(3) == 0);
+    CHECK(std::isinf(lights.getPointLightRadius(4)));
+
+    auto toScreen = mtr::Matrix::getViewport(0, 128, 0, 128) *
+                    mtr::Matrix::getPerspectiveProjectionWithAngle(1.5f, 1,
+                                                                   0.1f, 100) *
+                    mtr::Matrix::getView({0, 0, 0, 1}, {0, 0, -1, 1},
+                                         {0, 1, 0, 0});
+    LightTiles tiles;
+    tiles.build(lights, toScreen, 128, 100);
+    auto listed = [&](uint32_t x, uint32_t y) {
+        auto list = tiles.lightsOf(x, y);
+        return std::vector<uint32_t>(list.begin(), list.end());
+    };
+    CHECK(listed(110, 64) == std::vector<uint32_t>({0, 1, 4}));
+    CHECK(listed(10, 64) == std::vector<uint32_t>({1, 4}));
+    CHECK(listed(127, 99) == std::vector<uint32_t>({1, 4}));
+
+    // shading by all listed lights is the same as by all lights
+    vec::Vec3F point{-3, 0, -9}, normal{0, 0, 1}, albedo{1, 1, 1};
+    auto expected = lights.calculatePhongColor(point, normal, albedo, albedo,
+                                               {0, 0, 0}, 8);
+    std::vector<uint32_t> all{0, 1, 2, 3, 4};
+    auto actual = lights.calculatePhongColor(point, normal, albedo, albedo,
+                                             {0, 0, 0}, 8, all);
+    CHECK(actual.ambient == expected.ambient);
+    CHECK(actual.diffuse == expected.diffuse);
+    CHECK(actual.specular == expected.specular);
+}
+
+TEST_CASE("Packet shading gives the same colors as shading by pixel")
+{
+    std::mt19937 mt(7);
+    std::uniform_real_distribution coordinate(-2.0f, 2.0f);
+    std::uniform_real_distribution weight(0.0f, 1.0f);
+    std::vector<Vertex> vertices;
+    std::vector<Normal> normals;
+    for (unsigned i = 0; i < 3; i++) {
+        vertices.push_back({coordinate(mt), coordinate(mt), coordinate(mt), 1});
+        normals.push_back(
+            Normal{coordinate(mt), coordinate(mt), coordinate(mt)}.normalize());
+    }
+    Triangle triangle{0, 1, 2};
+    ent::LightArray lights;
+    lights.push_back(ent::DistantLight{{0, 0.6f, 0.8f}, {255, 255, 255}, 0.2f});
+    lights.push_back(ent::PointLight{{1, 2, 3}, {200, 100, 50}, 0.1f, 1, 0.5f,
+                                     0.1f});
+    lights.push_back(ent::PointLight{{-2, 0, 1}, {50, 100, 200}, 0.1f, 1, 0,
+                                     0.3f});
+    shader::NoTexturePhongShader shader{lights,
+                                        vertices.cbegin(),
+                                        normals.cbegin(),
+                                        {0.5f, 0.7f, 0.9f},
+                                        {0, 0, 5},
+                                        16};
+    shader.setPacketShading(shader::PacketShading::Packets);
+    for (unsigned i = 0; i < 300; i++) {
+        auto mode = std::array{ent::SpecularMode::Exact,
+                               ent::SpecularMode::Table,
+                               ent::SpecularMode::Schlick}[i % 3];
+        lights.setSpecularMode(mode);
+        lights.prepareSpecular(16);
+        PixelPacket packet{8, 3, 0b10110111, {}, {}, {}, triangle};
+        for (std::size_t lane = 0; lane < packetSize; lane++) {
+            auto u = weight(mt), v = weight(mt) * (1 - u);
+            packet.u[lane] = u;
+            packet.v[lane] = v;
+            packet.w[lane] = 1 - u - v;
+        }
+        auto colors = shader(packet);
+        for (auto mask = packet.mask; mask != 0; mask &= mask - 1) {
+            auto lane = static_cast<std::size_t>(std::countr_zero(mask));
+            auto expected =
+                shader(packet.u[lane], packet.v[lane], packet.w[lane], triangle);
+            CHECK(colors.x[lane] == expected[0]);
+            CHECK(colors.y[lane] == expected[1]);
+            CHECK(colors.z[lane] == expected[2]);
+        }
+    }
+}
+
+TEST_CASE("Fast specular power is close to exact one")
+{
+    for (floating shine : {1.0f, 2.0f, 8.0f, 32.0f, 128.0f, 256.0f}) {
+        ent::SpecularPower table, schlick;
+        table.setMode(ent::SpecularMode::Table);
+        table.prepare(shine);
+        schlick.setMode(ent::SpecularMode::Schlick);
+        schlick.prepare(shine);
+        for (unsigned i = 0; i <= 10000; i++) {
+            auto cosine = static_cast<floating>(i) / 10000;
+            auto exact = std::pow(cosine, shine);
+            CHECK(std::fabs(table(cosine, shine) - exact) < 1e-3f);
+            // approximation keeps shape of highlight, not its values
+            CHECK(std::fabs(schlick(cosine, shine) - exact) < 0.25f);
+        }
+        CHECK(table(1, shine) == 1);
+        CHECK(schlick(1, shine) == 1);
+        CHECK(table(-0.5f, shine) == 0);
+        CHECK(schlick(NAN, shine) == 0);
+        // not prepared shine is raised exactly
+        CHECK(table(0.5f, shine + 1) == std::pow(0.5f, shine + 1));
+    }
+}
+
+TEST_CASE("Triangle setup interpolates attributes of current triangle")
+{
+    // texel (x, y) of texture holds x and y
+    constexpr uint32_t size = 64;
+    std::vector<char> data(size * size * 3);
+    for (uint32_t y = 0; y < size; y++)
+        for (uint32_t x = 0; x < size; x++) {
+            data[(y * size + x) * 3] = static_cast<char>(x);
+            data[(y * size + x) * 3 + 1] = static_cast<char>(y);
+        }
+    ent::Texture texture{data.data(), size, size, 3};
+    std::vector<Vertex> vertices{{0, 0, 0.5f, 1}, {0, 0, 0.5f, 4},
+                                 {0, 0, 0.5f, 2}, {0, 0, 0.5f, 8}};
+    std::vector<TextureCoord> coordinates{
+        {0.1f, 0.9f, 0}, {0.9f, 0.8f, 0}, {0.5f, 0.1f, 0}, {0.2f, 0.3f, 0}};
+    std::vector<Normal> normals{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0, -1, 0}};
+    std::array triangles{Triangle{0, 1, 2}, Triangle{3, 1, 2}};
+    shader::TextureAlbedo albedo{vertices.cbegin(), coordinates.cbegin(),
+                                 texture, ent::TextureFilter::Nearest};
+    shader::NormalInterpolation interpolation{normals.cbegin()};
+
+    std::mt19937 mt(11);
+    std::uniform_real_distribution weight(0.0f, 1.0f);
+    for (unsigned i = 0; i < 1000; i++) {
+        // triangles alternate, so every pixel needs setup again
+        const auto &triangle = triangles[i % 2];
+        auto u = weight(mt), v = weight(mt) * (1 - u), w = 1 - u - v;
+
+        floating perspective = 0, x = 0, y = 0;
+        Normal normal{};
+        for (std::size_t k = 0; k < 3; k++) {
+            auto offset = triangle[k];
+            auto weightOfVertex = std::array{u, v, w}[k];
+            auto coordinate = coordinates[offset];
+            perspective += weightOfVertex / vertices[offset][3];
+            x += weightOfVertex * (coordinate[0] * size - 0.5f) /
+                 vertices[offset][3];
+            y += weightOfVertex * ((1 - coordinate[1]) * size - 0.5f) /
+                 vertices[offset][3];
+            normal += normals[offset] * weightOfVertex;
+        }
+        x /= perspective;
+        y /= perspective;
+        auto texel = albedo(u, v, w, triangle) * 0xFF;
+        if (std::fabs(x - std::round(x)) > 1e-3f)
+            CHECK(std::round(texel[0]) == std::floor(x));
+        if (std::fabs(y - std::round(y)) > 1e-3f)
+            CHECK(std::round(texel[1]) == std::floor(y));
+
+        auto interpolated = interpolation(u, v, w, triangle);
+        normal.normalize();
+        for (std::size_t k = 0; k < 3; k++)
+            CHECK(interpolated[k] == doctest::Approx(normal[k]));
+    }
+}
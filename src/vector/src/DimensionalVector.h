@@ -123,7 +123,7 @@ operator+(const DimensionalVector<dimensions, Component> &a,
           const DimensionalVector<dimensions, Component> &b)
 {
     auto z = a;
-    return z *= b;
+    return z += b;
 }
 
 template <size_t dimensions, numeric Component>
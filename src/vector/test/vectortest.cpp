@@ -28,6 +28,13 @@ TEST_CASE("Vector plus")
     CHECK_EQ(expected, a);
 }
 
+TEST_CASE("Vector sum")
+{
+    Vec2F a{3, 4}, b{8, -1.1};
+    Vec2F expected{11, 2.9};
+    CHECK_EQ(expected, a + b);
+}
+
 TEST_CASE("Vector mul")
 {
     Vec2F a{3, 4}, b{8, 11};